@@ -1,279 +1,183 @@
 #include <iostream>
 #include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
 #include <mpi.h>
-#include <algorithm>
-#include <set>
+#include "graph.h"
+#include "graph_io.h"
+#include "distributed_dfs.h"
+#include "distributed_frontier.h"
 using namespace std;
 
-struct DomainInfo {
-    int rank;
-    int numRanks;
-    int startVertex;
-    int endVertex;
-    int localSize;
-};
-
-DomainInfo setupDomain(int totalVertices, int rank, int numRanks) {
-    DomainInfo domain;
-    domain.rank = rank;
-    domain.numRanks = numRanks;
-    
-    int baseSize = totalVertices / numRanks;
-    int remainder = totalVertices % numRanks;
-    
-    if (rank < remainder) {
-        domain.localSize = baseSize + 1;
-        domain.startVertex = rank * domain.localSize;
-    } else {
-        domain.localSize = baseSize;
-        domain.startVertex = remainder * (baseSize + 1) + (rank - remainder) * baseSize;
-    }
-    
-    domain.endVertex = domain.startVertex + domain.localSize;
-    
-    return domain;
-}
-
-bool isLocalVertex(int vertex, const DomainInfo& domain) {
-    return vertex >= domain.startVertex && vertex < domain.endVertex;
-}
-
-int findOwnerRank(int vertex, int totalVertices, int numRanks) {
-    int baseSize = totalVertices / numRanks;
-    int remainder = totalVertices % numRanks;
-    
-    int threshold = remainder * (baseSize + 1);
-    if (vertex < threshold) {
-        return vertex / (baseSize + 1);
-    } else {
-        return remainder + (vertex - threshold) / baseSize;
-    }
-}
-
-bool localDFS(const vector<vector<int>>& adj, vector<bool>& visited, 
-              int vertex, vector<int>& localResult, 
-              set<int>& boundaryVertices, const DomainInfo& domain,
-              int target, bool& found) {
-    
-    if (visited[vertex]) return false;
-    
-    visited[vertex] = true;
-    localResult.push_back(vertex);
-    
-    if (vertex == target) {
-        found = true;
-        return true;
-    }
-    
-    double work = 0;
-    for (int i = 0; i < 1000; i++) {
-        work += (vertex * i) % 100;
-    }
-    
-    for (int neighbor : adj[vertex]) {
-        if (isLocalVertex(neighbor, domain)) {
-            if (!visited[neighbor]) {
-                if (localDFS(adj, visited, neighbor, localResult, boundaryVertices, domain, target, found)) {
-                    return true;
-                }
-            }
-        } else {
-            boundaryVertices.insert(neighbor);
-        }
-    }
-    
-    return false;
-}
-
-bool isBoundaryVertex(int vertex, const vector<vector<int>>& adj, const DomainInfo& domain) {
-    if (!isLocalVertex(vertex, domain)) return false;
-    
-    for (int neighbor : adj[vertex]) {
-        if (!isLocalVertex(neighbor, domain)) {
-            return true;
-        }
-    }
-    return false;
-}
-
-pair<vector<int>, bool> dfs_mpi_with_overlap(const vector<vector<int>>& adj, 
-                                              const DomainInfo& domain, 
-                                              int target) {
-    int totalVertices = adj.size();
-    vector<bool> visited(totalVertices, false);
-    vector<int> localResult;
-    set<int> boundaryVertices;
-    bool targetFound = false;
-    
-    vector<int> interiorVertices;
-    vector<int> localBoundaryVertices;
-    
-    for (int v = domain.startVertex; v < domain.endVertex; v++) {
-        if (isBoundaryVertex(v, adj, domain)) {
-            localBoundaryVertices.push_back(v);
-        } else {
-            interiorVertices.push_back(v);
-        }
-    }
-    
-    vector<MPI_Request> recvRequests;
-    vector<vector<int>> recvBuffers(domain.numRanks);
-    vector<int> recvSizes(domain.numRanks, 0);
-    
-    for (int srcRank = 0; srcRank < domain.numRanks; srcRank++) {
-        if (srcRank != domain.rank) {
-            MPI_Request req;
-            MPI_Irecv(&recvSizes[srcRank], 1, MPI_INT, srcRank, 0, 
-                     MPI_COMM_WORLD, &req);
-            recvRequests.push_back(req);
-        }
-    }
-    
-    set<int> externalVerticesSet;
-    for (int v : localBoundaryVertices) {
-        for (int neighbor : adj[v]) {
-            if (!isLocalVertex(neighbor, domain)) {
-                externalVerticesSet.insert(neighbor);
-            }
-        }
-    }
-    
-    vector<MPI_Request> sendRequests;
-    vector<vector<int>> sendBuffers(domain.numRanks);
+int main(int argc, char** argv) {
+    // Hybrid mode only calls MPI from the master thread
+    int threadSupport = MPI_THREAD_SINGLE;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &threadSupport);
     
-    for (int extV : externalVerticesSet) {
-        int ownerRank = findOwnerRank(extV, totalVertices, domain.numRanks);
-        if (ownerRank != domain.rank) {
-            sendBuffers[ownerRank].push_back(extV);
-        }
-    }
+    int rank, numRanks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numRanks);
     
-    for (int destRank = 0; destRank < domain.numRanks; destRank++) {
-        if (destRank != domain.rank) {
-            int size = sendBuffers[destRank].size();
-            
-            MPI_Request sizeReq;
-            MPI_Isend(&size, 1, MPI_INT, destRank, 0, MPI_COMM_WORLD, &sizeReq);
-            sendRequests.push_back(sizeReq);
-            
-            if (size > 0) {
-                MPI_Request dataReq;
-                MPI_Isend(sendBuffers[destRank].data(), size, MPI_INT, 
-                         destRank, 1, MPI_COMM_WORLD, &dataReq);
-                sendRequests.push_back(dataReq);
-            }
-        }
-    }
+    int numVertices = 50000;
+    int targetVertex = 42000;
+    int sourceVertex = 0;
+    PartitionScheme scheme = PartitionScheme::Block;
     
-    for (int v : interiorVertices) {
-        if (!visited[v] && !targetFound) {
-            set<int> dummy;
-            if (localDFS(adj, visited, v, localResult, dummy, domain, target, targetFound)) {
-                break;
-            }
+    if (argc >= 2 && !parsePartitionScheme(argv[1], scheme)) {
+        if (rank == 0) {
+            cerr << "unknown partition scheme: " << argv[1] << " (use block, bfs, rcm or lp)" << endl;
         }
+        MPI_Finalize();
+        return 1;
     }
-    
-    if (!recvRequests.empty()) {
-        MPI_Waitall(recvRequests.size(), recvRequests.data(), MPI_STATUSES_IGNORE);
+    // Threads per rank; more than one selects the hybrid MPI + OpenMP engine
+    int numThreads = 1;
+    if (argc >= 3) {
+        numThreads = atoi(argv[2]);
     }
-    
-    recvRequests.clear();
-    for (int srcRank = 0; srcRank < domain.numRanks; srcRank++) {
-        if (srcRank != domain.rank && recvSizes[srcRank] > 0) {
-            recvBuffers[srcRank].resize(recvSizes[srcRank]);
-            MPI_Request req;
-            MPI_Irecv(recvBuffers[srcRank].data(), recvSizes[srcRank], MPI_INT, 
-                     srcRank, 1, MPI_COMM_WORLD, &req);
-            recvRequests.push_back(req);
+    if (numThreads > 1 && threadSupport < MPI_THREAD_FUNNELED) {
+        if (rank == 0) {
+            cerr << "MPI library lacks MPI_THREAD_FUNNELED, using 1 thread per rank" << endl;
         }
+        numThreads = 1;
     }
-    
-    if (!recvRequests.empty()) {
-        MPI_Waitall(recvRequests.size(), recvRequests.data(), MPI_STATUSES_IGNORE);
-    }
-    
-    for (int v : localBoundaryVertices) {
-        if (!visited[v] && !targetFound) {
-            localDFS(adj, visited, v, localResult, boundaryVertices, domain, target, targetFound);
-        }
+    if (numThreads < 1) {
+        numThreads = 1;
     }
     
-    for (int srcRank = 0; srcRank < domain.numRanks; srcRank++) {
-        if (srcRank != domain.rank && !targetFound) {
-            for (int v : recvBuffers[srcRank]) {
-                if (isLocalVertex(v, domain) && !visited[v]) {
-                    set<int> dummy;
-                    if (localDFS(adj, visited, v, localResult, dummy, domain, target, targetFound)) {
-                        break;
-                    }
-                }
-            }
+    // The gRPC wrapper passes the request through the environment.
+    // TRACE_FILE also asks for the per-phase timeline of the exchange rounds,
+    // and TRAVERSAL_MODE=frontier replaces the DFS with the frontier
+    // traversal, which reaches the same vertices but keeps no preorder.
+    const char* traceFile = nullptr;
+    TraversalMode mode = TraversalMode::DFS;
+    int modeOk = 1;
+    if (rank == 0) {
+        if (const char* env = getenv("NUM_VERTICES")) numVertices = atoi(env);
+        if (const char* env = getenv("TARGET_VERTEX")) targetVertex = atoi(env);
+        traceFile = getenv("TRACE_FILE");
+        modeOk = traversalModeFromEnv(mode);
+    }
+    int settings[3] = {traceFile != nullptr, (int)mode, modeOk};
+    MPI_Bcast(settings, 3, MPI_INT, 0, MPI_COMM_WORLD);
+    if (!settings[2]) {
+        if (rank == 0) cerr << "unknown TRAVERSAL_MODE (use dfs or frontier)" << endl;
+        MPI_Finalize();
+        return 1;
+    }
+    mode = (TraversalMode)settings[1];
+    bool frontierMode = mode == TraversalMode::Frontier;
+    int tracing = settings[0] && !frontierMode;
+    if (rank == 0 && settings[0] && frontierMode) {
+        cerr << "TRACE_FILE only traces the DFS exchange rounds, ignoring it" << endl;
+    }
+    // CHECKPOINT_DIR: save the DFS state every CHECKPOINT_INTERVAL seconds,
+    // and resume from the last checkpoint of the same query if there is one
+    CheckpointConfig checkpointConfig = checkpointConfigFromEnv(rank);
+    if (rank == 0 && checkpointConfig.enabled() && frontierMode) {
+        cerr << "CHECKPOINT_DIR only applies to the DFS, ignoring it" << endl;
+    }
+    
+    // Every rank maps the same file; co-located ranks share its pages
+    CSRGraph fileGraph;
+    const char* graphFile = graphFileFromEnv();
+    if (graphFile) {
+        string error;
+        if (!mapGraphFile(graphFile, fileGraph, error)) {
+            cerr << "rank " << rank << ": " << error << endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
         }
+        numVertices = fileGraph.size();
     }
-    
-    if (!sendRequests.empty()) {
-        MPI_Waitall(sendRequests.size(), sendRequests.data(), MPI_STATUSES_IGNORE);
-    }
-    
-    return {localResult, targetFound};
-}
-
-int main(int argc, char** argv) {
-    MPI_Init(&argc, &argv);
-    
-    int rank, numRanks;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &numRanks);
-    
-    int numVertices = 50000;
-    int targetVertex = 42000;
-    
     MPI_Bcast(&numVertices, 1, MPI_INT, 0, MPI_COMM_WORLD);
     MPI_Bcast(&targetVertex, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&sourceVertex, 1, MPI_INT, 0, MPI_COMM_WORLD);
     
-    vector<vector<int>> adj(numVertices);
+    // Only after the broadcast: the generator captures the graph size
+    auto circulant = circulantEdges(numVertices);
+    auto edges = [&](int v, auto&& emit) {
+        if (graphFile) {
+            for (int u : fileGraph[v]) emit(u);
+        } else {
+            circulant(v, emit);
+        }
+    };
     
     if (rank == 0) {
         cout << "running distributed DFS..." << endl;
         cout << "graph size: " << numVertices << " vertices" << endl;
+        if (graphFile) {
+            cout << "graph file: " << graphFile << endl;
+        }
         cout << "searching for vertex: " << targetVertex << endl;
-        cout << "using " << numRanks << " processes" << endl << endl;
-    }
-    
-    for (int i = 0; i < numVertices; i++) {
-        for (int j = 1; j <= 3; j++) {
-            int neighbor = (i + j * 7) % numVertices;
-            adj[i].push_back(neighbor);
+        cout << "starting from vertex: " << sourceVertex << endl;
+        cout << "traversal mode: " << traversalModeName(mode) << endl;
+        cout << "using " << numRanks << " processes";
+        if (numThreads > 1) {
+            cout << " x " << numThreads << " threads (hybrid)";
         }
+        cout << endl << endl;
     }
     
-    DomainInfo domain = setupDomain(numVertices, rank, numRanks);
+    DistributedGraph graph = partitionAndBuild(numVertices, rank, numRanks, scheme, edges);
+    const DomainInfo& domain = graph.domain;
+    PartitionStats partStats = gatherPartitionStats(graph);
     
     if (rank == 0) {
-        cout << "domain decomposition (1D block):" << endl;
+        cout << "domain decomposition (" << partitionSchemeName(scheme) << "):" << endl;
+        cout << "edge cut: " << partStats.edgeCut << " of " << partStats.totalEdges
+             << " edges (" << (partStats.cutFraction() * 100.0) << "%)" << endl;
+        cout << "boundary vertices: " << partStats.boundaryVertices << endl;
+        cout << "load imbalance: " << partStats.imbalance << " (part sizes "
+             << partStats.minPartSize << " to " << partStats.maxPartSize << ")" << endl;
     }
     for (int r = 0; r < numRanks; r++) {
-        if (rank == r) {
+        if (rank == r && !graph.tableOwnership) {
             cout << "rank " << rank << " owns vertices " << domain.startVertex 
-                 << " to " << (domain.endVertex-1) << endl;
+                 << " to " << (domain.endVertex-1) << " (" << graph.local.numEdges()
+                 << " edges, " << graph.numGhosts() << " ghosts, "
+                 << graph.memoryBytes() / 1024 << " KB)" << endl;
+        } else if (rank == r) {
+            cout << "rank " << rank << " owns " << domain.localSize
+                 << " vertices (" << graph.local.numEdges()
+                 << " edges, " << graph.numGhosts() << " ghosts, "
+                 << graph.memoryBytes() / 1024 << " KB)" << endl;
         }
         MPI_Barrier(MPI_COMM_WORLD);
     }
     
+    // The in-edge exchange is part of loading the graph, not of the query
+    unique_ptr<DistributedFrontier> frontier(frontierMode ? new DistributedFrontier(graph) : nullptr);
+    
     MPI_Barrier(MPI_COMM_WORLD);
+    unique_ptr<PhaseTrace> trace(tracing ? new PhaseTrace() : nullptr);
+    unique_ptr<TraversalCheckpoint> checkpoint(
+        checkpointConfig.enabled() && !frontierMode
+            ? new TraversalCheckpoint(checkpointConfig, graph, sourceVertex, targetVertex)
+            : nullptr);
     double startTime = MPI_Wtime();
     
-    auto [localResult, localFound] = dfs_mpi_with_overlap(adj, domain, targetVertex);
+    DistributedDFSResult dfsResult;
+    DistributedFrontierResult frontierResult;
+    if (frontier) {
+        frontierResult = frontier->run(sourceVertex, targetVertex, numThreads);
+    } else {
+        dfsResult = numThreads > 1
+            ? dfs_mpi_hybrid(graph, sourceVertex, targetVertex, numThreads, NoRoundObserver(), trace.get(),
+                             checkpoint.get())
+            : dfs_mpi_with_overlap(graph, sourceVertex, targetVertex, NoRoundObserver(), trace.get(),
+                                   checkpoint.get());
+    }
     
     MPI_Barrier(MPI_COMM_WORLD);
     double endTime = MPI_Wtime();
     
-    int localCount = localResult.size();
+    int localCount = frontier ? (int)frontierResult.localVisited : (int)dfsResult.localResult.size();
     int totalCount = 0;
     MPI_Reduce(&localCount, &totalCount, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
     
-    int foundFlag = localFound ? 1 : 0;
+    int foundFlag = (frontier ? frontierResult.found : dfsResult.found) ? 1 : 0;
     int globalFound = 0;
     MPI_Reduce(&foundFlag, &globalFound, 1, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD);
     
@@ -285,6 +189,12 @@ int main(int argc, char** argv) {
         cout << endl;
         cout << "time taken: " << (maxTime * 1000.0) << " ms" << endl;
         cout << "vertices visited: " << totalCount << endl;
+        if (frontier) {
+            cout << "frontier levels: " << frontierResult.levels << " ("
+                 << frontierResult.bottomUpLevels << " bottom-up)" << endl;
+        } else {
+            cout << "exchange rounds: " << dfsResult.rounds << endl;
+        }
         if (globalFound) {
             cout << "found target: vertex " << targetVertex << endl;
         } else {
@@ -292,6 +202,39 @@ int main(int argc, char** argv) {
         }
     }
     
+    if (checkpoint) {
+        long long written = checkpoint->written(), allWritten = 0;
+        MPI_Reduce(&written, &allWritten, 1, MPI_LONG_LONG, MPI_MIN, 0, MPI_COMM_WORLD);
+        string error = checkpoint->error();
+        if (!error.empty()) {
+            cerr << "rank " << rank << ": checkpoint failed: " << error << endl;
+        }
+        if (rank == 0) {
+            if (checkpoint->resumedSeq() > 0) {
+                cout << "resumed from checkpoint " << checkpoint->resumedSeq() << " (after round "
+                     << checkpoint->resumedRound() << ")" << endl;
+            }
+            cout << "checkpoints written: " << allWritten << " (every "
+                 << checkpointConfig.intervalSeconds << " s to " << checkpointConfig.directory << ")" << endl;
+        }
+    }
+    
+    if (trace) {
+        vector<PhaseSummary> summaries = gatherPhaseSummaries(*trace, domain);
+        vector<vector<TraceEvent>> events = gatherTraceEvents(*trace, domain);
+        if (rank == 0) {
+            cout << endl;
+            printPhaseSummaries(cout, summaries);
+            ofstream out(traceFile);
+            if (out) {
+                writeChromeTrace(out, events);
+                cout << "phase trace written to " << traceFile << endl;
+            } else {
+                cerr << "cannot write " << traceFile << endl;
+            }
+        }
+    }
+    
     MPI_Finalize();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#ifndef ATOMIC_BITMAP_H
+#define ATOMIC_BITMAP_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Packed visited set shared between threads: one bit per vertex, claimed
+// with a single fetch_or so no lock is needed to mark a vertex.
+class AtomicBitmap {
+public:
+    explicit AtomicBitmap(size_t numBits)
+        : numBits_(numBits),
+          numWords_((numBits + 63) / 64),
+          owned_(new std::atomic<uint64_t>[numWords_]),
+          words_(owned_.get()) {
+        clear();
+    }
+
+    // Words in zero-filled memory owned elsewhere (a placed mapping, see
+    // numa_topology.h) that keepAlive holds. They are left unwritten, so
+    // the threads that clearWords() them decide which NUMA node their
+    // pages land on.
+    AtomicBitmap(size_t numBits, void* words, std::shared_ptr<const void> keepAlive)
+        : numBits_(numBits),
+          numWords_((numBits + 63) / 64),
+          keepAlive_(std::move(keepAlive)),
+          words_(static_cast<std::atomic<uint64_t>*>(words)) {}
+
+    size_t size() const { return numBits_; }
+
+    bool test(int v) const {
+        return (words_[v >> 6].load(std::memory_order_relaxed) & mask(v)) != 0;
+    }
+
+    // Returns true only for the one caller that flips v from unset to set.
+    // The relaxed pre-check skips the read-modify-write (and the cache line
+    // ownership transfer it costs) when v is already visited.
+    bool tryClaim(int v) {
+        std::atomic<uint64_t>& word = words_[v >> 6];
+        uint64_t bit = mask(v);
+        if (word.load(std::memory_order_relaxed) & bit) return false;
+        return (word.fetch_or(bit, std::memory_order_acq_rel) & bit) == 0;
+    }
+
+    void clear() { clearWords(0, numWords_); }
+
+    void clearWords(size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            words_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Word-level access for scans that skip 64 vertices at a time
+    size_t numWords() const { return numWords_; }
+
+    uint64_t word(size_t i) const { return words_[i].load(std::memory_order_relaxed); }
+
+    // Number of set bits; not synchronized with concurrent claims
+    size_t count() const {
+        size_t total = 0;
+        for (size_t i = 0; i < numWords_; i++) total += __builtin_popcountll(word(i));
+        return total;
+    }
+
+    void swap(AtomicBitmap& other) {
+        std::swap(numBits_, other.numBits_);
+        std::swap(numWords_, other.numWords_);
+        owned_.swap(other.owned_);
+        keepAlive_.swap(other.keepAlive_);
+        std::swap(words_, other.words_);
+    }
+
+private:
+    static uint64_t mask(int v) { return uint64_t(1) << (v & 63); }
+
+    size_t numBits_;
+    size_t numWords_;
+    std::unique_ptr<std::atomic<uint64_t>[]> owned_;
+    std::shared_ptr<const void> keepAlive_;
+    std::atomic<uint64_t>* words_;      // owned_ or the memory keepAlive_ holds
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef BATCH_REACHABILITY_H
+#define BATCH_REACHABILITY_H
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdint>
+#include <omp.h>
+#include "graph.h"
+
+// Answers for a batch of (source, target) queries, in query order
+struct BatchReachability {
+    std::vector<char> found;            // target reachable from source
+    std::vector<int> reachedCount;      // vertices reachable from the query's source
+    int sweeps = 0;                     // graph sweeps (one per 64 distinct sources)
+};
+
+// Answer many reachability queries with one shared sweep per 64 distinct
+// sources instead of one traversal per query. Every vertex carries a
+// 64-bit word whose bit i says "reached from source i"; a vertex is
+// (re)pushed whenever it gains bits, and passes on only the bits its
+// neighbor is missing, so overlapping traversals are walked once.
+// Bit groups are independent and run in parallel.
+//
+// sources may be empty (every query starts at vertex 0), hold a single
+// source shared by all queries, or hold one source per target. Queries
+// with an out-of-range endpoint get found = 0 and reachedCount = 0.
+inline BatchReachability batchReachability(const CSRGraph& adj, const std::vector<int>& sources,
+                                           const std::vector<int>& targets) {
+    const int WORD_BITS = 64;
+    int n = adj.size();
+    int numQueries = targets.size();
+    BatchReachability result;
+    result.found.assign(numQueries, 0);
+    result.reachedCount.assign(numQueries, 0);
+
+    auto sourceOf = [&](int q) {
+        if (sources.empty()) return 0;
+        return sources.size() == 1 ? sources[0] : sources[q];
+    };
+
+    // Distinct valid sources, in first-seen order
+    std::map<int, int> slotOf;
+    std::vector<int> distinct;
+    for (int q = 0; q < numQueries; q++) {
+        int s = sourceOf(q);
+        if (s >= 0 && s < n && slotOf.emplace(s, distinct.size()).second) distinct.push_back(s);
+    }
+    int numGroups = (distinct.size() + WORD_BITS - 1) / WORD_BITS;
+    result.sweeps = numGroups;
+    std::vector<int> countOfSlot(distinct.size(), 0);
+    std::vector<std::vector<uint64_t>> targetWords(numGroups);
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int g = 0; g < numGroups; g++) {
+        int first = g * WORD_BITS;
+        int last = std::min<int>(distinct.size(), first + WORD_BITS);
+
+        std::vector<uint64_t> reached(n, 0);
+        std::vector<char> queued(n, 0);
+        std::vector<int> work;
+        for (int i = first; i < last; i++) {
+            int s = distinct[i];
+            reached[s] |= uint64_t(1) << (i - first);
+            if (!queued[s]) {
+                queued[s] = 1;
+                work.push_back(s);
+            }
+        }
+        while (!work.empty()) {
+            int v = work.back();
+            work.pop_back();
+            queued[v] = 0;
+            uint64_t bits = reached[v];
+            for (int u : adj[v]) {
+                uint64_t gained = bits & ~reached[u];
+                if (!gained) continue;
+                reached[u] |= gained;
+                if (!queued[u]) {
+                    queued[u] = 1;
+                    work.push_back(u);
+                }
+            }
+        }
+
+        for (int v = 0; v < n; v++) {
+            for (uint64_t m = reached[v]; m; m &= m - 1) {
+                countOfSlot[first + __builtin_ctzll(m)]++;
+            }
+        }
+        // Keep only the words the queries look at
+        std::vector<uint64_t>& words = targetWords[g];
+        words.resize(numQueries, 0);
+        for (int q = 0; q < numQueries; q++) {
+            int t = targets[q];
+            if (t >= 0 && t < n) words[q] = reached[t];
+        }
+    }
+
+    for (int q = 0; q < numQueries; q++) {
+        int s = sourceOf(q);
+        int t = targets[q];
+        if (s < 0 || s >= n || t < 0 || t >= n) continue;
+        int slot = slotOf[s];
+        result.found[q] = (targetWords[slot / WORD_BITS][q] >> (slot % WORD_BITS)) & 1;
+        result.reachedCount[q] = countOfSlot[slot];
+    }
+    return result;
+}
+
+#endif
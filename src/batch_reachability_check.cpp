@@ -0,0 +1,108 @@
+#include <iostream>
+#include <vector>
+#include <set>
+#include <random>
+#include <algorithm>
+#include <string>
+#include <cstdlib>
+#include "graph.h"
+#include "batch_reachability.h"
+using namespace std;
+
+// Randomized check of batchReachability: answers random query batches on
+// small random graphs and compares found and reachedCount with a plain DFS
+// per query.
+//
+//   batch_reachability_check [trials] [seed]
+//
+// Batches use all three source layouts (none, one shared, one per target),
+// sometimes more than 64 distinct sources so several bit groups run,
+// repeated sources, and out-of-range endpoints.
+
+// Vertices reachable from s, or none if s is out of range
+static vector<char> reachableFrom(const CSRGraph& graph, int s) {
+    int n = graph.size();
+    vector<char> reached(n, 0);
+    if (s < 0 || s >= n) return reached;
+    vector<int> stack = {s};
+    reached[s] = 1;
+    while (!stack.empty()) {
+        int v = stack.back();
+        stack.pop_back();
+        for (int u : graph[v]) {
+            if (reached[u]) continue;
+            reached[u] = 1;
+            stack.push_back(u);
+        }
+    }
+    return reached;
+}
+
+// A random endpoint: usually a vertex, sometimes just outside [0, n)
+static int randomEndpoint(mt19937& rng, int n) {
+    if (rng() % 50 == 0) return rng() % 2 ? -1 : n;
+    return rng() % n;
+}
+
+int main(int argc, char** argv) {
+    int trials = argc > 1 ? atoi(argv[1]) : 300;
+    unsigned seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+    mt19937 rng(seed);
+    long long queries = 0;
+    long long sweeps = 0;
+    for (int t = 0; t < trials; t++) {
+        int n = 1 + rng() % 300;
+        int degree = rng() % 4;
+        vector<vector<int>> lists(n);
+        for (int v = 0; v < n; v++) {
+            for (int j = rng() % (2 * degree + 1); j > 0; j--) lists[v].push_back(rng() % n);
+        }
+        CSRGraph graph = buildGraph(n, [&](int v, auto&& emit) {
+            for (int u : lists[v]) emit(u);
+        });
+
+        // Per-target sources are partly drawn from a small pool, so they repeat
+        int numQueries = rng() % 250;
+        int layout = rng() % 3;
+        int pool = 1 + rng() % 150;
+        vector<int> targets, sources;
+        for (int q = 0; q < numQueries; q++) targets.push_back(randomEndpoint(rng, n));
+        if (layout == 1) sources.push_back(randomEndpoint(rng, n));
+        if (layout == 2) {
+            for (int q = 0; q < numQueries; q++) sources.push_back(rng() % 4 ? randomEndpoint(rng, n) : rng() % min(n, pool));
+        }
+
+        BatchReachability result = batchReachability(graph, sources, targets);
+        set<int> distinct;
+        for (int q = 0; q < numQueries; q++) {
+            int s = layout == 0 ? 0 : layout == 1 ? sources[0] : sources[q];
+            int target = targets[q];
+            vector<char> reached = reachableFrom(graph, s);
+            bool valid = s >= 0 && s < n && target >= 0 && target < n;
+            bool found = valid && reached[target];
+            int count = 0;
+            if (valid) {
+                for (char r : reached) count += r;
+            }
+            if (s >= 0 && s < n) distinct.insert(s);
+            if ((bool)result.found[q] != found || result.reachedCount[q] != count) {
+                cerr << "batch_reachability_check: trial " << t << " (seed " << seed << "): query " << q << " ("
+                     << s << " -> " << target << ") gave found=" << (int)result.found[q]
+                     << " reachedCount=" << result.reachedCount[q] << ", DFS says found=" << found
+                     << " reachedCount=" << count << endl;
+                return 1;
+            }
+        }
+        int expectedSweeps = (distinct.size() + 63) / 64;
+        if (result.sweeps != expectedSweeps) {
+            cerr << "batch_reachability_check: trial " << t << " (seed " << seed << "): " << result.sweeps
+                 << " sweeps for " << distinct.size() << " distinct sources" << endl;
+            return 1;
+        }
+        queries += numQueries;
+        sweeps += result.sweeps;
+    }
+    cout << "batch_reachability_check: " << trials << " trials ok (" << queries << " queries, " << sweeps
+         << " sweeps)" << endl;
+    return 0;
+}
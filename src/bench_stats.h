@@ -0,0 +1,233 @@
+#ifndef BENCH_STATS_H
+#define BENCH_STATS_H
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <chrono>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include "perf_counters.h"
+
+// Summary of the timed runs of one configuration, in seconds. The warmup
+// runs (first touch of the graph, page faults, thread pool start-up) are
+// measured but left out of every statistic.
+struct RunStats {
+    int warmup = 0;
+    int runs = 0;
+    double median = 0;
+    double p95 = 0;
+    double mean = 0;
+    double stddev = 0;      // sample standard deviation
+    double min = 0;
+    double max = 0;
+};
+
+// times[0..warmup) are discarded; p95 uses the nearest-rank definition
+inline RunStats summarizeRuns(const std::vector<double>& times, int warmup) {
+    RunStats stats;
+    stats.warmup = std::min<int>(warmup, times.size());
+    std::vector<double> kept(times.begin() + stats.warmup, times.end());
+    stats.runs = kept.size();
+    if (kept.empty()) return stats;
+
+    std::sort(kept.begin(), kept.end());
+    size_t n = kept.size();
+    stats.median = n % 2 ? kept[n / 2] : 0.5 * (kept[n / 2 - 1] + kept[n / 2]);
+    size_t rank95 = (size_t)std::ceil(0.95 * n);
+    stats.p95 = kept[std::max<size_t>(rank95, 1) - 1];
+    stats.min = kept.front();
+    stats.max = kept.back();
+
+    double sum = 0;
+    for (double t : kept) sum += t;
+    stats.mean = sum / n;
+    double squares = 0;
+    for (double t : kept) squares += (t - stats.mean) * (t - stats.mean);
+    stats.stddev = n > 1 ? std::sqrt(squares / (n - 1)) : 0.0;
+    return stats;
+}
+
+// Wall time of warmup + runs calls of run(), in seconds. beforeTimed()
+// runs once between the warmup and the first timed run and afterTimed()
+// once after the last, e.g. to count hardware events over the timed runs
+template <typename Run, typename Before, typename After>
+std::vector<double> timeRuns(int warmup, int runs, Run run, Before beforeTimed, After afterTimed) {
+    std::vector<double> times;
+    for (int i = 0; i < warmup + runs; i++) {
+        if (i == warmup) beforeTimed();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double>(end - start).count());
+    }
+    afterTimed();
+    return times;
+}
+
+template <typename Run>
+std::vector<double> timeRuns(int warmup, int runs, Run run) {
+    return timeRuns(warmup, runs, run, []() {}, []() {});
+}
+
+// timeRuns with counters running over the timed runs only; counts are
+// per run afterwards
+template <typename Run>
+std::vector<double> timeRunsCounted(int warmup, int runs, Run run, PerfCounters& counters,
+                                    std::vector<CounterValues>& perThread) {
+    std::vector<double> times = timeRuns(warmup, runs, run,
+        [&]() { counters.start(); }, [&]() { counters.stop(); });
+    perThread = counters.perThread();
+    for (CounterValues& values : perThread) values.scale(runs > 0 ? 1.0 / runs : 0.0);
+    return times;
+}
+
+// One measured configuration: which engine ran on which graph, with what
+// parallelism, and how it did
+struct BenchmarkRecord {
+    std::string engine;         // serial, openmp, mpi or hybrid
+    std::string graph;          // generator name or file path
+    int vertices = 0;
+    long long edges = 0;
+    int threads = 1;            // threads per rank
+    int ranks = 1;
+    int stride = 1;
+    long long visited = 0;
+    long long edgesTraversed = 0;   // out-edges of the visited vertices
+    RunStats time;
+    bool counted = false;               // counters below were recorded
+    CounterValues counters;             // per timed run, summed over threads and ranks
+    std::vector<CounterValues> threadCounters;  // per timed run, each thread of rank 0
+    std::string placement = "default";  // NUMA memory placement (openmp)
+    std::string affinity = "none";      // THREAD_AFFINITY map (openmp)
+    std::vector<double> nodeVisited;    // per timed run, by each NUMA node's threads (openmp)
+
+    double edgesPerSecond() const { return time.median > 0 ? edgesTraversed / time.median : 0.0; }
+
+    // Vertices per second visited by node's threads, at the median time
+    double nodeVerticesPerSecond(int node) const {
+        return time.median > 0 ? nodeVisited[node] / time.median : 0.0;
+    }
+};
+
+inline std::string jsonEscape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+inline const char* benchmarkCSVHeader() {
+    return "engine,graph,vertices,edges,threads,ranks,stride,visited,edges_traversed,"
+           "warmup,runs,median_s,p95_s,mean_s,stddev_s,min_s,max_s,edges_per_s,"
+           "cycles,instructions,l1d_misses,llc_misses,dtlb_misses,branch_misses,"
+           "task_clock_ns,page_faults,ipc,placement,affinity,node_vertices_per_s";
+}
+
+// Counter columns of a CSV row; a counter that was not recorded is empty
+inline void writeCounterCSV(std::ostream& out, bool counted, const CounterValues& values) {
+    for (int id = 0; id < NUM_COUNTERS; id++) {
+        out << ",";
+        if (counted && values.valid[id]) out << values.value[id];
+    }
+    out << ",";
+    if (counted && values.ipc() > 0) out << values.ipc();
+}
+
+// {"cycles": ..., ..., "ipc": ...}; a counter that was not recorded is null
+inline void writeCounterJSON(std::ostream& out, const CounterValues& values) {
+    out << "{";
+    for (int id = 0; id < NUM_COUNTERS; id++) {
+        out << "\"" << counterName(id) << "\": ";
+        if (values.valid[id]) out << values.value[id];
+        else out << "null";
+        out << ", ";
+    }
+    out << "\"ipc\": ";
+    if (values.ipc() > 0) out << values.ipc();
+    else out << "null";
+    out << "}";
+}
+
+inline void writeBenchmarkCSV(std::ostream& out, const std::vector<BenchmarkRecord>& records) {
+    out << benchmarkCSVHeader() << "\n" << std::setprecision(9);
+    for (const BenchmarkRecord& r : records) {
+        out << r.engine << "," << r.graph << "," << r.vertices << "," << r.edges << ","
+            << r.threads << "," << r.ranks << "," << r.stride << "," << r.visited << ","
+            << r.edgesTraversed << "," << r.time.warmup << "," << r.time.runs << ","
+            << r.time.median << "," << r.time.p95 << "," << r.time.mean << ","
+            << r.time.stddev << "," << r.time.min << "," << r.time.max << ","
+            << r.edgesPerSecond();
+        writeCounterCSV(out, r.counted, r.counters);
+        // One value per NUMA node, separated by ';'
+        out << "," << r.placement << ",\"" << r.affinity << "\",";
+        for (size_t k = 0; k < r.nodeVisited.size(); k++) {
+            out << (k ? ";" : "") << r.nodeVerticesPerSecond(k);
+        }
+        out << "\n";
+    }
+}
+
+// {"records": [{...}, ...]}, one object per record with the CSV's fields;
+// counted records carry "counters" and "per_thread" objects instead of the
+// counter columns, and openmp records a "per_node" list instead of the
+// semicolon-joined node column
+inline void writeBenchmarkJSON(std::ostream& out, const std::vector<BenchmarkRecord>& records) {
+    out << "{\n  \"records\": [" << std::setprecision(9);
+    for (size_t i = 0; i < records.size(); i++) {
+        const BenchmarkRecord& r = records[i];
+        out << (i ? ",\n" : "\n") << "    {"
+            << "\"engine\": \"" << jsonEscape(r.engine) << "\", "
+            << "\"graph\": \"" << jsonEscape(r.graph) << "\", "
+            << "\"vertices\": " << r.vertices << ", "
+            << "\"edges\": " << r.edges << ", "
+            << "\"threads\": " << r.threads << ", "
+            << "\"ranks\": " << r.ranks << ", "
+            << "\"stride\": " << r.stride << ", "
+            << "\"visited\": " << r.visited << ", "
+            << "\"edges_traversed\": " << r.edgesTraversed << ", "
+            << "\"warmup\": " << r.time.warmup << ", "
+            << "\"runs\": " << r.time.runs << ", "
+            << "\"median_s\": " << r.time.median << ", "
+            << "\"p95_s\": " << r.time.p95 << ", "
+            << "\"mean_s\": " << r.time.mean << ", "
+            << "\"stddev_s\": " << r.time.stddev << ", "
+            << "\"min_s\": " << r.time.min << ", "
+            << "\"max_s\": " << r.time.max << ", "
+            << "\"edges_per_s\": " << r.edgesPerSecond() << ", "
+            << "\"placement\": \"" << jsonEscape(r.placement) << "\", "
+            << "\"affinity\": \"" << jsonEscape(r.affinity) << "\"";
+        if (!r.nodeVisited.empty()) {
+            out << ", \"per_node\": [";
+            for (size_t k = 0; k < r.nodeVisited.size(); k++) {
+                if (k) out << ", ";
+                out << "{\"visited\": " << r.nodeVisited[k]
+                    << ", \"vertices_per_s\": " << r.nodeVerticesPerSecond(k) << "}";
+            }
+            out << "]";
+        }
+        if (r.counted) {
+            out << ", \"counters\": ";
+            writeCounterJSON(out, r.counters);
+            out << ", \"per_thread\": [";
+            for (size_t t = 0; t < r.threadCounters.size(); t++) {
+                if (t) out << ", ";
+                writeCounterJSON(out, r.threadCounters[t]);
+            }
+            out << "]";
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+#endif
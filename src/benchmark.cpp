@@ -0,0 +1,553 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <iomanip>
+#include <memory>
+#include <omp.h>
+#include <mpi.h>
+#include "graph.h"
+#include "graph_io.h"
+#include "dfs_engine.h"
+#include "atomic_bitmap.h"
+#include "work_stealing_dfs.h"
+#include "distributed_dfs.h"
+#include "frontier_reach.h"
+#include "distributed_frontier.h"
+#include "bench_stats.h"
+#include "perf_counters.h"
+#include "numa_topology.h"
+using namespace std;
+
+// One benchmark suite for every engine on the same graphs:
+//
+//   benchmark [--graphs test,circulant] [--file graph.bin]... [--sizes 50000,200000]
+//             [--engines serial,openmp,mpi,hybrid,frontier,mpifront]
+//             [--threads 1,2,4,8] [--strides 1,4]
+//             [--scheme block|bfs|rcm|lp] [--warmup 1] [--runs 10]
+//             [--json results.json] [--csv results.csv] [--counters]
+//             [--placement default,firsttouch,interleave] [--affinity none|compact|scatter|0-7]
+//
+// serial and openmp sweep every root of the graph; mpi and hybrid run the
+// distributed reachability DFS from vertex 0 on all ranks of the launch.
+// frontier (OpenMP) and mpifront (all ranks, every --threads count per
+// rank) find the same vertices as mpi with the level-synchronous frontier
+// traversal; they take no stride and only run when asked for.
+// The shared-memory engines only run in a one-rank launch, since idle
+// ranks spinning in MPI would skew their timings; sweep the rank count by
+// launching once per count, e.g.
+//   for p in 1 2 4; do mpirun -np $p ./benchmark --json bench_$p.json; done
+// and pass all the files to generate_graphs.py.
+//
+// --counters also records hardware counters (cycles, instructions, cache,
+// dTLB and branch misses) per timed run of every configuration: for each
+// thread of rank 0, and summed over all threads of all ranks. Where
+// perf_event_open is unavailable the suite says so once and carries on
+// with timings only.
+//
+// --placement sweeps where the openmp engine's graph copy and visited
+// bitmap live, and --affinity (default: THREAD_AFFINITY) pins its threads
+// (see numa_topology.h). Every openmp record carries the vertices per
+// second visited by each NUMA node's threads, to check scaling past one
+// socket.
+
+vector<string> splitList(const string& text) {
+    vector<string> items;
+    stringstream in(text);
+    string item;
+    while (getline(in, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+vector<int> parseIntList(const string& text) {
+    vector<int> values;
+    for (const string& item : splitList(text)) values.push_back(atoi(item.c_str()));
+    return values;
+}
+
+struct BenchmarkOptions {
+    vector<string> generators = {"test", "circulant"};
+    vector<string> files;
+    vector<int> sizes = {50000};
+    vector<string> engines = {"serial", "openmp", "mpi", "hybrid"};
+    vector<int> threads = {1, 2, 4, 8};
+    vector<int> strides = {1};
+    PartitionScheme scheme = PartitionScheme::Block;
+    int warmup = 1;
+    int runs = 10;
+    string jsonPath;
+    string csvPath;
+    bool counters = false;
+    vector<MemoryPlacement> placements = {MemoryPlacement::Default};
+    string affinity = getenv("THREAD_AFFINITY") ? getenv("THREAD_AFFINITY") : "none";
+
+    bool wants(const string& engine) const {
+        for (const string& e : engines) {
+            if (e == engine) return true;
+        }
+        return false;
+    }
+};
+
+bool parseOptions(int argc, char** argv, BenchmarkOptions& options, string& error) {
+    for (int i = 1; i < argc; i++) {
+        string flag = argv[i];
+        if (flag == "--counters") {
+            options.counters = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            error = "missing value for " + flag;
+            return false;
+        }
+        string value = argv[++i];
+        if (flag == "--graphs") {
+            options.generators = splitList(value);
+        } else if (flag == "--file") {
+            options.files.push_back(value);
+        } else if (flag == "--sizes") {
+            options.sizes = parseIntList(value);
+        } else if (flag == "--engines") {
+            options.engines = splitList(value);
+        } else if (flag == "--threads") {
+            options.threads = parseIntList(value);
+        } else if (flag == "--strides") {
+            options.strides = parseIntList(value);
+        } else if (flag == "--scheme") {
+            if (!parsePartitionScheme(value, options.scheme)) {
+                error = "unknown partition scheme: " + value + " (use block, bfs, rcm or lp)";
+                return false;
+            }
+        } else if (flag == "--warmup") {
+            options.warmup = atoi(value.c_str());
+        } else if (flag == "--runs") {
+            options.runs = atoi(value.c_str());
+        } else if (flag == "--placement") {
+            options.placements.clear();
+            for (const string& name : splitList(value)) {
+                MemoryPlacement placement;
+                if (!parseMemoryPlacement(name, placement)) {
+                    error = "unknown placement: " + name + " (use default, firsttouch or interleave)";
+                    return false;
+                }
+                options.placements.push_back(placement);
+            }
+        } else if (flag == "--affinity") {
+            options.affinity = value;
+        } else if (flag == "--json") {
+            options.jsonPath = value;
+        } else if (flag == "--csv") {
+            options.csvPath = value;
+        } else {
+            error = "unknown option: " + flag;
+            return false;
+        }
+    }
+    if (options.runs < 1) options.runs = 1;
+    if (options.warmup < 0) options.warmup = 0;
+    return true;
+}
+
+// A graph every rank holds in full: generated, or mapped from a file
+struct BenchmarkGraph {
+    string name;
+    CSRGraph adj;
+};
+
+BenchmarkRecord makeRecord(const string& engine, const BenchmarkGraph& graph, int threads,
+                           int ranks, int stride) {
+    BenchmarkRecord record;
+    record.engine = engine;
+    record.graph = graph.name;
+    record.vertices = graph.adj.size();
+    record.edges = graph.adj.numEdges();
+    record.threads = threads;
+    record.ranks = ranks;
+    record.stride = stride;
+    return record;
+}
+
+// Times run() and, when counters are wanted and open, counts its timed
+// runs on each of the team's threads
+template <typename Run>
+vector<double> measureRuns(int threads, const BenchmarkOptions& options, Run run,
+                           BenchmarkRecord& record) {
+    if (options.counters) {
+        PerfCounters counters(threads);
+        if (counters.available()) {
+            vector<double> times = timeRunsCounted(options.warmup, options.runs, run, counters,
+                                                   record.threadCounters);
+            record.counters = PerfCounters::total(record.threadCounters);
+            record.counted = true;
+            return times;
+        }
+    }
+    return timeRuns(options.warmup, options.runs, run);
+}
+
+BenchmarkRecord benchSerial(const BenchmarkGraph& graph, int stride, const BenchmarkOptions& options) {
+    const CSRGraph& adj = graph.adj;
+    TraversalContext context(adj.size());
+    auto run = [&]() {
+        context.begin(adj.size());
+        for (int root = 0; root < adj.size(); root++) {
+            if (context.visited.test(root)) continue;
+            iterativeDFS(adj, context.visited, root, stride, context.stack,
+                         CollectVisit{context.result});
+        }
+    };
+    BenchmarkRecord record = makeRecord("serial", graph, 1, 1, stride);
+    record.time = summarizeRuns(measureRuns(1, options, run, record), options.warmup);
+    record.visited = context.result.size();
+    for (int v : context.result) record.edgesTraversed += adj.degree(v);
+    return record;
+}
+
+// Except for the default placement the graph is first copied into pages
+// placed for the layout
+BenchmarkRecord benchOpenMP(const BenchmarkGraph& graph, int threads, int stride,
+                            const NumaTopology& topology, const ThreadLayout& layout,
+                            MemoryPlacement placement, const BenchmarkOptions& options) {
+    WorkStealingDFS engine(threads);
+    engine.setLayout(layout);
+    CSRGraph placed;
+    string error;
+    if (placement != MemoryPlacement::Default &&
+        !placeGraph(graph.adj, placement, topology, layout, placed, error)) {
+        cout << "NUMA placement " << memoryPlacementName(placement) << " failed (" << error
+             << "), using default placement" << endl;
+        placement = MemoryPlacement::Default;
+    }
+    const CSRGraph& adj = placement == MemoryPlacement::Default ? graph.adj : placed;
+    AtomicBitmap visited = placedBitmap(adj, placement, topology, layout);
+
+    // Per-node visit counts summed over the timed runs only
+    vector<double> nodeVisited(layout.numNodes, 0.0);
+    int calls = 0;
+    auto run = [&]() {
+        visited.clear();
+        engine.run(adj, visited, stride, [](int, int, int) {});
+        if (++calls <= options.warmup) return;
+        const vector<WorkerStats>& stats = engine.stats();
+        for (int t = 0; t < (int)stats.size(); t++) nodeVisited[engine.nodeOf(t)] += stats[t].visited;
+    };
+    BenchmarkRecord record = makeRecord("openmp", graph, engine.numThreads(), 1, stride);
+    record.time = summarizeRuns(measureRuns(engine.numThreads(), options, run, record),
+                                options.warmup);
+    // Later engines get the OpenMP pool back unpinned
+    if (layout.pinned()) unpinThreads(topology, engine.numThreads());
+    record.placement = memoryPlacementName(placement);
+    record.affinity = layout.affinity;
+    for (double& count : nodeVisited) count /= options.runs;
+    record.nodeVisited = nodeVisited;
+    for (int v = 0; v < adj.size(); v++) {
+        if (visited.test(v)) {
+            record.visited++;
+            record.edgesTraversed += adj.degree(v);
+        }
+    }
+    return record;
+}
+
+BenchmarkRecord benchFrontier(const BenchmarkGraph& graph, const CSRGraph& reverse, int threads,
+                              const BenchmarkOptions& options) {
+    const CSRGraph& adj = graph.adj;
+    FrontierReach engine(adj, reverse, threads);
+    auto run = [&]() { engine.run(0, -1); };
+    BenchmarkRecord record = makeRecord("frontier", graph, engine.numThreads(), 1, 1);
+    record.time = summarizeRuns(measureRuns(engine.numThreads(), options, run, record),
+                                options.warmup);
+    for (int v = 0; v < adj.size(); v++) {
+        if (engine.visited().test(v)) {
+            record.visited++;
+            record.edgesTraversed += adj.degree(v);
+        }
+    }
+    return record;
+}
+
+// Sums every rank's counter totals into rank 0's record; a counter stays
+// valid only if every rank had it. Collective.
+void reduceCounters(BenchmarkRecord& record, int rank) {
+    int counted = record.counted, everywhere = 0;
+    MPI_Allreduce(&counted, &everywhere, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    if (!everywhere) {
+        record.counted = false;
+        return;
+    }
+    int valid[NUM_COUNTERS], allValid[NUM_COUNTERS];
+    for (int id = 0; id < NUM_COUNTERS; id++) valid[id] = record.counters.valid[id];
+    CounterValues total;
+    MPI_Reduce(record.counters.value, total.value, NUM_COUNTERS, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(valid, allValid, NUM_COUNTERS, MPI_INT, MPI_LAND, 0, MPI_COMM_WORLD);
+    if (rank != 0) return;
+    for (int id = 0; id < NUM_COUNTERS; id++) total.valid[id] = allValid[id];
+    record.counters = total;
+}
+
+// Times run() on every rank, taking the slowest rank's time per run, and
+// counts the timed runs on each of the rank's threads when counters are
+// wanted. Collective; the record is only meaningful on rank 0.
+template <typename Run>
+vector<double> measureDistributedRuns(int threads, int rank, const BenchmarkOptions& options, Run run,
+                                      BenchmarkRecord& record) {
+    unique_ptr<PerfCounters> counters;
+    if (options.counters) {
+        counters.reset(new PerfCounters(threads));
+        if (!counters->available()) counters.reset();
+    }
+    vector<double> times;
+    for (int i = 0; i < options.warmup + options.runs; i++) {
+        if (i == options.warmup && counters) counters->start();
+        MPI_Barrier(MPI_COMM_WORLD);
+        double start = MPI_Wtime();
+        run();
+        double local = MPI_Wtime() - start;
+        double slowest = 0;
+        MPI_Allreduce(&local, &slowest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        times.push_back(slowest);
+    }
+    if (counters) {
+        counters->stop();
+        record.threadCounters = counters->perThread();
+        for (CounterValues& values : record.threadCounters) values.scale(1.0 / options.runs);
+        record.counters = PerfCounters::total(record.threadCounters);
+        record.counted = true;
+    }
+    if (options.counters) reduceCounters(record, rank);
+    return times;
+}
+
+// Visited vertices and their edges, summed over all ranks into rank 0's
+// record. Collective.
+void reduceVisited(BenchmarkRecord& record, long long visited, long long edges) {
+    long long local[2] = {visited, edges};
+    long long total[2] = {0, 0};
+    MPI_Reduce(local, total, 2, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    record.visited = total[0];
+    record.edgesTraversed = total[1];
+}
+
+// Collective; the record is only meaningful on rank 0
+BenchmarkRecord benchDistributed(const BenchmarkGraph& graph, const DistributedGraph& dist,
+                                 int threads, bool hybrid, const BenchmarkOptions& options) {
+    int numRanks = dist.domain.numRanks;
+    TraversalContext context(dist.localSize());
+    BenchmarkRecord record = makeRecord(hybrid ? "hybrid" : "mpi", graph, threads, numRanks, 1);
+    DistributedDFSResult result;
+    auto run = [&]() {
+        result = hybrid ? dfs_mpi_hybrid(dist, 0, -1, threads)
+                        : dfs_mpi_with_overlap(dist, 0, -1, context);
+    };
+    vector<double> times = measureDistributedRuns(hybrid ? threads : 1, dist.domain.rank, options,
+                                                  run, record);
+
+    long long edges = 0;
+    for (int v : result.localResult) edges += graph.adj.degree(v);
+    reduceVisited(record, result.localResult.size(), edges);
+    record.time = summarizeRuns(times, options.warmup);
+    return record;
+}
+
+// Same for the distributed frontier traversal; frontier is built once per
+// partition, outside the timing. Collective.
+BenchmarkRecord benchDistributedFrontier(const BenchmarkGraph& graph, const DistributedGraph& dist,
+                                         DistributedFrontier& frontier, int threads,
+                                         const BenchmarkOptions& options) {
+    BenchmarkRecord record = makeRecord("mpifront", graph, threads, dist.domain.numRanks, 1);
+    auto run = [&]() { frontier.run(0, -1, threads); };
+    vector<double> times = measureDistributedRuns(threads, dist.domain.rank, options, run, record);
+
+    long long visited = 0, edges = 0;
+    for (int v = 0; v < dist.localSize(); v++) {
+        if (frontier.visited().test(v)) {
+            visited++;
+            edges += dist.local.degree(v);
+        }
+    }
+    reduceVisited(record, visited, edges);
+    record.time = summarizeRuns(times, options.warmup);
+    return record;
+}
+
+void printRecord(const BenchmarkRecord& r) {
+    cout << left << setw(10) << r.engine << setw(22) << r.graph << right
+         << setw(10) << r.vertices << setw(5) << r.threads << setw(5) << r.ranks
+         << setw(5) << r.stride << fixed << setprecision(3)
+         << setw(11) << r.time.median * 1000.0 << setw(11) << r.time.p95 * 1000.0
+         << setw(10) << r.time.stddev * 1000.0
+         << setw(10) << setprecision(1) << r.edgesPerSecond() / 1e6;
+    if (r.counted) {
+        // Per timed run and visited vertex, so graphs of any size compare
+        double perVertex = r.visited > 0 ? 1.0 / r.visited : 0.0;
+        auto column = [&](int id, int width) {
+            if (r.counters.valid[id]) cout << setw(width) << setprecision(2) << r.counters.value[id] * perVertex;
+            else cout << setw(width) << "-";
+        };
+        if (r.counters.ipc() > 0) cout << setw(6) << setprecision(2) << r.counters.ipc();
+        else cout << setw(6) << "-";
+        column(CNT_L1D_MISSES, 9);
+        column(CNT_LLC_MISSES, 9);
+        column(CNT_DTLB_MISSES, 9);
+        column(CNT_BRANCH_MISSES, 9);
+    }
+    cout << endl;
+    if (r.nodeVisited.size() > 1 || r.placement != "default" || r.affinity != "none") {
+        cout << "    placement " << r.placement << ", affinity " << r.affinity << ", Mvertex/s per node:";
+        for (size_t k = 0; k < r.nodeVisited.size(); k++) {
+            cout << " " << setprecision(1) << r.nodeVerticesPerSecond(k) / 1e6;
+        }
+        cout << endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    int threadSupport = MPI_THREAD_SINGLE;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &threadSupport);
+    int rank, numRanks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numRanks);
+
+    BenchmarkOptions options;
+    string error;
+    if (!parseOptions(argc, argv, options, error)) {
+        if (rank == 0) cerr << error << endl;
+        MPI_Finalize();
+        return 1;
+    }
+    bool sharedMemory = numRanks == 1;
+    if (rank == 0 && !sharedMemory && (options.wants("serial") || options.wants("openmp"))) {
+        cout << "skipping serial and openmp engines with " << numRanks
+             << " ranks (run them in a one-rank launch)" << endl;
+    }
+    bool hybridAllowed = threadSupport >= MPI_THREAD_FUNNELED;
+    if (rank == 0 && options.wants("hybrid") && !hybridAllowed) {
+        cout << "skipping hybrid engine: MPI library lacks MPI_THREAD_FUNNELED" << endl;
+    }
+
+    vector<BenchmarkGraph> graphs;
+    for (const string& generator : options.generators) {
+        for (int n : options.sizes) {
+            BenchmarkGraph graph;
+            if (generator == "test") {
+                graph.adj = createTestGraph(n);
+            } else if (generator == "circulant") {
+                graph.adj = createCirculantGraph(n);
+            } else {
+                if (rank == 0) cerr << "unknown graph generator: " << generator << " (use test or circulant)" << endl;
+                MPI_Finalize();
+                return 1;
+            }
+            graph.name = generator;
+            graphs.push_back(move(graph));
+        }
+    }
+    for (const string& path : options.files) {
+        BenchmarkGraph graph;
+        if (!mapGraphFile(path, graph.adj, error)) {
+            cerr << "rank " << rank << ": " << error << endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        graph.name = path;
+        graphs.push_back(move(graph));
+    }
+
+    if (options.counters) {
+        PerfCounters probe(1);
+        int available = probe.available(), everywhere = 0;
+        MPI_Allreduce(&available, &everywhere, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+        if (rank == 0 && !everywhere) {
+            cout << "hardware counters unavailable"
+                 << (available ? " on some ranks" : " (" + probe.unavailableReason() + ")")
+                 << ", recording timings only" << endl;
+        } else if (rank == 0 && !probe.missingEvents().empty()) {
+            cout << "some hardware counters missing (" << probe.missingEvents() << ")" << endl;
+        }
+        options.counters = everywhere;
+    }
+
+    NumaTopology topology = detectNumaTopology();
+    if (rank == 0) {
+        cout << "benchmark: " << numRanks << " rank(s), " << options.warmup << " warmup + "
+             << options.runs << " timed runs per configuration, " << topology.numNodes()
+             << " NUMA node(s)" << endl;
+        cout << left << setw(10) << "engine" << setw(22) << "graph" << right
+             << setw(10) << "vertices" << setw(5) << "thr" << setw(5) << "rnk"
+             << setw(5) << "str" << setw(11) << "median_ms" << setw(11) << "p95_ms"
+             << setw(10) << "stdev_ms" << setw(10) << "Medge/s";
+        if (options.counters) {
+            cout << setw(6) << "ipc" << setw(9) << "L1D/v" << setw(9) << "LLC/v"
+                 << setw(9) << "dTLB/v" << setw(9) << "brmis/v";
+        }
+        cout << endl;
+    }
+
+    vector<BenchmarkRecord> records;
+    auto add = [&](const BenchmarkRecord& record) {
+        if (rank != 0) return;
+        records.push_back(record);
+        printRecord(record);
+    };
+
+    for (const BenchmarkGraph& graph : graphs) {
+        if (sharedMemory) {
+            for (int stride : options.strides) {
+                if (options.wants("serial")) add(benchSerial(graph, stride, options));
+                if (options.wants("openmp")) {
+                    for (int threads : options.threads) {
+                        ThreadLayout layout;
+                        if (!makeThreadLayout(topology, threads, options.affinity, layout)) {
+                            cerr << "bad affinity: " << options.affinity
+                                 << " (use none, compact, scatter or a CPU list such as 0-3,8)" << endl;
+                            MPI_Finalize();
+                            return 1;
+                        }
+                        for (MemoryPlacement placement : options.placements) {
+                            add(benchOpenMP(graph, threads, stride, topology, layout, placement, options));
+                        }
+                    }
+                }
+            }
+            if (options.wants("frontier")) {
+                CSRGraph reverse = transposeGraph(graph.adj);
+                for (int threads : options.threads) add(benchFrontier(graph, reverse, threads, options));
+            }
+        }
+        bool frontierDistributed = options.wants("mpifront");
+        if (options.wants("mpi") || (options.wants("hybrid") && hybridAllowed) || frontierDistributed) {
+            DistributedGraph dist = partitionAndBuild(graph.adj.size(), rank, numRanks,
+                                                      options.scheme, csrEdges(graph.adj));
+            if (options.wants("mpi")) add(benchDistributed(graph, dist, 1, false, options));
+            if (options.wants("hybrid") && hybridAllowed) {
+                for (int threads : options.threads) add(benchDistributed(graph, dist, threads, true, options));
+            }
+            if (frontierDistributed) {
+                DistributedFrontier frontier(dist);
+                for (int threads : options.threads) {
+                    if (threads > 1 && !hybridAllowed) continue;
+                    add(benchDistributedFrontier(graph, dist, frontier, threads, options));
+                }
+            }
+        }
+    }
+
+    if (rank == 0) {
+        if (!options.jsonPath.empty()) {
+            ofstream out(options.jsonPath);
+            writeBenchmarkJSON(out, records);
+            cout << "wrote " << options.jsonPath << endl;
+        }
+        if (!options.csvPath.empty()) {
+            ofstream out(options.csvPath);
+            writeBenchmarkCSV(out, records);
+            cout << "wrote " << options.csvPath << endl;
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
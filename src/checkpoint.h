@@ -0,0 +1,331 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <dirent.h>
+#include <unistd.h>
+#include <mpi.h>
+#include "distributed_graph.h"
+
+// Periodic checkpoints of a distributed traversal, so a job that dies can
+// resume from the last one instead of starting over. Between exchange
+// rounds the state of a rank is small and complete: the owned vertices
+// it has visited, the received vertices it has yet to traverse, the ghosts
+// it has found but not yet sent (plus the ones it has sent, so it never
+// sends them again) and its part of the result. No DFS stack is live at
+// that point, since every traversal runs to completion inside its round.
+//
+// Every rank writes its own file, <dir>/dfs_s<source>_t<target>_r<rank>_<seq>.ckpt,
+// so dir can be node-local storage (if the job restarts on the same
+// nodes) or a parallel file system shared by a failover replica. The
+// state is copied when a checkpoint is due and written by a background
+// thread while the rounds go on; a file is complete once renamed from its
+// .tmp name. Since writes are asynchronous, checkpoint k may exist on some
+// ranks and not yet on others; recovery picks the newest one every rank
+// has, and each rank keeps its last CHECKPOINT_KEEP around for that.
+const int CHECKPOINT_KEEP = 3;
+
+// One rank's state after a round
+struct CheckpointImage {
+    int round = 0;
+    std::vector<int> localResult;       // global ids, in visit order
+    std::vector<int> pending;           // local ids received, not yet traversed
+    std::vector<int> queuedGhosts;      // ghost indices found, not yet sent
+    std::vector<uint64_t> markedGhosts; // ghost bitmap: ever queued
+    std::vector<uint64_t> visited;      // owned local id bitmap
+};
+
+struct CheckpointHeader {
+    char magic[8];
+    int32_t numRanks, rank, totalVertices, localSize, numGhosts, source, target, round;
+    int64_t seq;
+    uint64_t graphHash;
+    int64_t resultCount, pendingCount, queuedCount, markedWords, visitedWords;
+};
+
+const char CHECKPOINT_MAGIC[8] = {'D', 'F', 'S', 'C', 'K', 'P', 'T', '1'};
+
+// FNV-1a over the partition's shape, so a checkpoint is never restored
+// into a differently partitioned graph
+inline uint64_t partitionHash(const DistributedGraph& graph) {
+    uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&](uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            hash ^= (value >> (8 * i)) & 0xff;
+            hash *= 1099511628211ULL;
+        }
+    };
+    mix(graph.totalVertices);
+    mix(graph.localSize());
+    mix(graph.local.numEdges());
+    for (int v = 0; v < graph.localSize(); v += std::max(1, graph.localSize() / 1024)) mix(graph.toGlobal(v));
+    for (int g : graph.ghostGlobal) mix(g);
+    return hash;
+}
+
+// Checkpoints are on when CHECKPOINT_DIR is set; CHECKPOINT_INTERVAL is
+// the time between them in seconds (default 30)
+struct CheckpointConfig {
+    std::string directory;
+    double intervalSeconds = 30.0;
+
+    bool enabled() const { return !directory.empty(); }
+};
+
+// Read on rank 0 like the drivers' other settings and broadcast. Collective.
+inline CheckpointConfig checkpointConfigFromEnv(int rank) {
+    CheckpointConfig config;
+    if (rank == 0) {
+        if (const char* dir = std::getenv("CHECKPOINT_DIR")) config.directory = dir;
+        if (const char* interval = std::getenv("CHECKPOINT_INTERVAL")) {
+            config.intervalSeconds = std::atof(interval);
+        }
+    }
+    int length = config.directory.size();
+    MPI_Bcast(&length, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    config.directory.resize(length);
+    MPI_Bcast(&config.directory[0], length, MPI_CHAR, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&config.intervalSeconds, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    return config;
+}
+
+class TraversalCheckpoint {
+public:
+    TraversalCheckpoint(const CheckpointConfig& config, const DistributedGraph& graph, int source,
+                        int target)
+        : config_(config), graph_(graph), source_(source), target_(target),
+          graphHash_(partitionHash(graph)), lastSave_(MPI_Wtime()) {
+        prefix_ = rankPrefix(graph.domain.rank);
+    }
+
+    ~TraversalCheckpoint() { wait(); }
+
+    TraversalCheckpoint(const TraversalCheckpoint&) = delete;
+    TraversalCheckpoint& operator=(const TraversalCheckpoint&) = delete;
+
+    // Loads the newest checkpoint of this traversal that every rank has.
+    // Collective; false (on every rank) if there is none.
+    bool restore(CheckpointImage& image) {
+        std::vector<int64_t> mine = completeSeqs();
+        int64_t candidate = mine.empty() ? 0 : mine.back();
+        MPI_Allreduce(MPI_IN_PLACE, &candidate, 1, MPI_INT64_T, MPI_MIN, MPI_COMM_WORLD);
+        while (candidate > 0) {
+            int ok = std::binary_search(mine.begin(), mine.end(), candidate) && read(candidate, image);
+            MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+            if (ok) {
+                seq_ = resumedSeq_ = candidate;
+                resumedRound_ = image.round;
+                lastSave_ = MPI_Wtime();
+                return true;
+            }
+            // Next older one all ranks might share
+            int64_t older = 0;
+            for (int64_t s : mine) {
+                if (s < candidate) older = s;
+            }
+            MPI_Allreduce(&older, &candidate, 1, MPI_INT64_T, MPI_MIN, MPI_COMM_WORLD);
+        }
+        // Starting over: older files would only confuse the next recovery,
+        // including those of ranks a larger earlier job had
+        for (int64_t s : mine) std::remove(path(s).c_str());
+        if (graph_.domain.rank == 0) {
+            for (int r = graph_.domain.numRanks;; r++) {
+                std::string prefix = rankPrefix(r);
+                std::vector<int64_t> stale = seqsWithPrefix(prefix);
+                if (stale.empty()) break;
+                for (int64_t s : stale) std::remove(path(prefix, s).c_str());
+            }
+        }
+        image = CheckpointImage();
+        return false;
+    }
+
+    // This rank thinks a checkpoint is due; the rounds agree on it
+    // collectively so every rank saves the same round
+    bool due() const { return MPI_Wtime() - lastSave_ >= config_.intervalSeconds; }
+
+    // Hands the state to the writer thread, after the previous write is done
+    void save(CheckpointImage&& image) {
+        wait();
+        lastSave_ = MPI_Wtime();
+        int64_t seq = ++seq_;
+        writer_ = std::thread([this, seq](CheckpointImage state) { write(seq, state); }, std::move(image));
+    }
+
+    // The traversal finished: nothing left to resume, so drop this rank's files
+    void complete() {
+        wait();
+        for (int64_t seq : completeSeqs()) std::remove(path(seq).c_str());
+    }
+
+    long long written() const { return written_.load(); }
+    long long resumedSeq() const { return resumedSeq_; }
+    int resumedRound() const { return resumedRound_; }
+
+    // First write error on this rank, empty if none
+    std::string error() {
+        std::lock_guard<std::mutex> lock(errorMutex_);
+        return error_;
+    }
+
+private:
+    std::string rankPrefix(int rank) const {
+        return "dfs_s" + std::to_string(source_) + "_t" + std::to_string(target_) + "_r" +
+               std::to_string(rank) + "_";
+    }
+
+    std::string path(const std::string& prefix, int64_t seq, const char* suffix = ".ckpt") const {
+        return config_.directory + "/" + prefix + std::to_string(seq) + suffix;
+    }
+
+    std::string path(int64_t seq, const char* suffix = ".ckpt") const {
+        return path(prefix_, seq, suffix);
+    }
+
+    void wait() {
+        if (writer_.joinable()) writer_.join();
+    }
+
+    void fail(const std::string& message) {
+        std::lock_guard<std::mutex> lock(errorMutex_);
+        if (error_.empty()) error_ = message;
+    }
+
+    // Sequence numbers of this rank's complete files for this traversal, ascending
+    std::vector<int64_t> completeSeqs() const { return seqsWithPrefix(prefix_); }
+
+    std::vector<int64_t> seqsWithPrefix(const std::string& prefix) const {
+        std::vector<int64_t> seqs;
+        DIR* dir = opendir(config_.directory.c_str());
+        if (!dir) return seqs;
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.compare(0, prefix.size(), prefix) != 0) continue;
+            char* end = nullptr;
+            long long seq = std::strtoll(name.c_str() + prefix.size(), &end, 10);
+            if (seq > 0 && std::strcmp(end, ".ckpt") == 0) seqs.push_back(seq);
+        }
+        closedir(dir);
+        std::sort(seqs.begin(), seqs.end());
+        return seqs;
+    }
+
+    CheckpointHeader header(int64_t seq, const CheckpointImage& image) const {
+        CheckpointHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+        h.numRanks = graph_.domain.numRanks;
+        h.rank = graph_.domain.rank;
+        h.totalVertices = graph_.totalVertices;
+        h.localSize = graph_.localSize();
+        h.numGhosts = graph_.numGhosts();
+        h.source = source_;
+        h.target = target_;
+        h.round = image.round;
+        h.seq = seq;
+        h.graphHash = graphHash_;
+        h.resultCount = image.localResult.size();
+        h.pendingCount = image.pending.size();
+        h.queuedCount = image.queuedGhosts.size();
+        h.markedWords = image.markedGhosts.size();
+        h.visitedWords = image.visited.size();
+        return h;
+    }
+
+    // Writer thread: no MPI calls here
+    void write(int64_t seq, const CheckpointImage& image) {
+        std::string tmp = path(seq, ".tmp");
+        FILE* out = std::fopen(tmp.c_str(), "wb");
+        if (!out) {
+            fail("cannot create " + tmp + ": " + std::strerror(errno));
+            return;
+        }
+        CheckpointHeader h = header(seq, image);
+        bool ok = std::fwrite(&h, sizeof(h), 1, out) == 1;
+        auto put = [&](const auto& values) {
+            if (ok && !values.empty()) {
+                ok = std::fwrite(values.data(), sizeof(values[0]), values.size(), out) == values.size();
+            }
+        };
+        put(image.localResult);
+        put(image.pending);
+        put(image.queuedGhosts);
+        put(image.markedGhosts);
+        put(image.visited);
+        ok = std::fflush(out) == 0 && ok;
+        ok = fsync(fileno(out)) == 0 && ok;
+        ok = std::fclose(out) == 0 && ok;
+        if (!ok || std::rename(tmp.c_str(), path(seq).c_str()) != 0) {
+            fail("cannot write " + tmp + ": " + std::strerror(errno));
+            std::remove(tmp.c_str());
+            return;
+        }
+        written_++;
+        for (int64_t old : completeSeqs()) {
+            if (old <= seq - CHECKPOINT_KEEP) std::remove(path(old).c_str());
+        }
+    }
+
+    bool read(int64_t seq, CheckpointImage& image) const {
+        FILE* in = std::fopen(path(seq).c_str(), "rb");
+        if (!in) return false;
+        CheckpointHeader h;
+        CheckpointHeader expected = header(seq, CheckpointImage());
+        bool ok = std::fread(&h, sizeof(h), 1, in) == 1 &&
+                  std::memcmp(h.magic, expected.magic, sizeof(h.magic)) == 0 &&
+                  h.numRanks == expected.numRanks && h.rank == expected.rank &&
+                  h.totalVertices == expected.totalVertices && h.localSize == expected.localSize &&
+                  h.numGhosts == expected.numGhosts && h.source == expected.source &&
+                  h.target == expected.target && h.graphHash == expected.graphHash &&
+                  h.resultCount >= 0 && h.resultCount <= h.localSize &&
+                  h.pendingCount >= 0 && h.queuedCount >= 0 && h.queuedCount <= h.numGhosts &&
+                  h.markedWords == (h.numGhosts + 63) / 64 && h.visitedWords == (h.localSize + 63) / 64;
+        auto get = [&](auto& values, int64_t count) {
+            if (!ok) return;
+            values.resize(count);
+            if (count > 0) ok = std::fread(values.data(), sizeof(values[0]), count, in) == (size_t)count;
+        };
+        if (ok) image.round = h.round;
+        get(image.localResult, h.resultCount);
+        get(image.pending, h.pendingCount);
+        get(image.queuedGhosts, h.queuedCount);
+        get(image.markedGhosts, h.markedWords);
+        get(image.visited, h.visitedWords);
+        ok = ok && std::fgetc(in) == EOF;
+        std::fclose(in);
+        for (size_t i = 0; ok && i < image.pending.size(); i++) {
+            ok = image.pending[i] >= 0 && image.pending[i] < h.localSize;
+        }
+        for (size_t i = 0; ok && i < image.queuedGhosts.size(); i++) {
+            ok = image.queuedGhosts[i] >= 0 && image.queuedGhosts[i] < h.numGhosts;
+        }
+        return ok;
+    }
+
+    CheckpointConfig config_;
+    const DistributedGraph& graph_;
+    int source_;
+    int target_;
+    uint64_t graphHash_;
+    std::string prefix_;
+    double lastSave_;
+    int64_t seq_ = 0;
+    long long resumedSeq_ = 0;
+    int resumedRound_ = 0;
+    std::atomic<long long> written_{0};
+    std::thread writer_;
+    std::mutex errorMutex_;
+    std::string error_;
+};
+
+#endif
@@ -0,0 +1,656 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <memory>
+#include <mpi.h>
+#include "graph.h"
+#include "graph_io.h"
+#include "distributed_dfs.h"
+#include "distributed_frontier.h"
+#include "reachability_index.h"
+#include "batch_reachability.h"
+#include "result_cache.h"
+#include "dynamic_forest.h"
+using namespace std;
+
+// Long-running distributed DFS service. The graph is partitioned once and
+// stays resident on every rank; requests arrive as lines on rank 0's
+// stdin, are broadcast to all ranks, and each gets one reply line on
+// rank 0's stdout. grpc_service/server.py --daemon keeps one of these
+// running behind DFSService instead of launching MPI_DFS per request.
+//
+//   usage: dfs_daemon [block|bfs|rcm|lp] [threads per rank]
+//
+// Protocol (one line each way):
+//   run [target=<v>] [source=<s>] [vertices=<n>] [mode=dfs|frontier|forest]
+//       -> ok found=<0|1> visited=<n> runtime_ms=<t> rounds=<r> vertices=<n> target=<v>
+//          cached=<0|1> mode=<dfs|frontier>
+//          (frontier: the level-synchronous traversal of distributed_frontier.h,
+//          no preorder; rounds counts its levels. forest: answered on rank 0
+//          from the maintained DFS forest, see below; rounds=0)
+//   stream [target=<v>] [source=<s>] [vertices=<n>] [chunk=<k>] [mode=...]
+//       (always a DFS, since the chunks are its preorder; mode is ignored)
+//       -> after every exchange round, on separate lines:
+//            found vertex=<v> elapsed_ms=<t> round=<r>   (once, the round it happens)
+//            chunk <v1,v2,...>                           (that round's preorder, <= k ids)
+//            progress visited=<n> elapsed_ms=<t> round=<r>
+//          then the same final "ok ..." line as run
+//   reach [target=<v>] [source=<s>] [vertices=<n>]
+//       -> ok reachable=<0|1> components=<k>
+//   batch targets=<t1,t2,...> [sources=<s1,...>] [vertices=<n>]
+//       -> ok found=<0|1,...> reached=<n1,...> runtime_ms=<t> sweeps=<k>
+//          (sources: none = vertex 0, one = shared, or one per target)
+//   update [delete=<u>:<v>,...] [insert=<u>:<v>,...] [vertices=<n>]
+//       -> ok inserted=<i> deleted=<d> ignored=<k> moved=<m> components=<c> reached=<n>
+//          runtime_ms=<t>
+//          (deletions first; edges are a set, so inserting an existing edge or
+//          deleting a missing one is ignored; moved counts the vertices the
+//          forest repair re-placed)
+//   forest [vertex=<v>] [vertices=<n>]
+//       -> ok components=<c> reached=<n> updates=<u> moved=<m>
+//          [parent=<p> component=<r> component_size=<s>]
+//   stats -> ok cache_hits=<h> cache_misses=<m> index_fallbacks=<f>
+//   ping  -> ok
+//   quit (or end of input) -> process exits
+// Malformed requests get "error <message>". The daemon prints
+// "ready vertices=<n>" once the initial graph is built. Asking for a
+// different vertex count re-partitions the generated graph; with
+// GRAPH_FILE set the size is fixed by the file.
+//
+// Repeated run requests are answered from a cache of recent results, and
+// reach requests from a ReachabilityIndex that rank 0 builds on first use;
+// batch requests run batchReachability on rank 0's copy of the full graph.
+// None of these involve the other ranks, and all are dropped when the
+// graph changes.
+//
+// Edge updates are broadcast to every rank, which layers them over its
+// copy of the graph (EdgeOverlay). Rank 0 also keeps a DFS forest of the
+// whole graph and repairs it after each update, so "run mode=forest"
+// (source 0 only) and "forest" are answered from it without a traversal.
+// It starts as serial.cpp's forest (roots tried from vertex 0 up); after
+// repairs it is a valid DFS forest for some root order, with vertex 0's
+// tree exact. The partitioned graph is rebuilt from the overlay the next
+// time a traversal needs it.
+
+enum DaemonCommand { CMD_QUIT = 0, CMD_RUN = 1, CMD_REACH = 2, CMD_STATS = 3, CMD_BATCH = 4,
+                     CMD_STREAM = 5, CMD_UPDATE = 6, CMD_FOREST = 7 };
+
+// request[] layout, broadcast to every rank for CMD_RUN and CMD_STREAM
+enum { REQ_COMMAND, REQ_VERTICES, REQ_TARGET, REQ_SOURCE, REQ_CHUNK, REQ_MODE, REQ_VERTEX,
+       REQ_FIELDS };
+
+// REQ_MODE value for run requests answered from the forest, past the
+// TraversalMode values
+const int FOREST_MODE = 2;
+
+const int DEFAULT_CHUNK = 4096;
+
+struct RunResult {
+    bool found;
+    int visited;
+    double runtimeMs;
+    int rounds;
+};
+
+// Streams a traversal while it runs: after each round every rank's new
+// preorder entries are gathered to rank 0, which writes them out in chunks
+// followed by a progress line. The found event goes out first in the round
+// the target was found (the stop signal keeps that round short).
+class StreamingObserver {
+public:
+    StreamingObserver(const DomainInfo& domain, int chunkSize, int targetVertex, double startTime)
+        : rank_(domain.rank), chunkSize_(chunkSize < 1 ? DEFAULT_CHUNK : chunkSize),
+          targetVertex_(targetVertex), startTime_(startTime),
+          counts_(domain.numRanks), displs_(domain.numRanks) {}
+
+    void operator()(const DistributedDFSResult& result, size_t roundStart, bool found) {
+        int count = result.localResult.size() - roundStart;
+        MPI_Gather(&count, 1, MPI_INT, counts_.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+        int total = 0;
+        if (rank_ == 0) {
+            for (size_t r = 0; r < counts_.size(); r++) {
+                displs_[r] = total;
+                total += counts_[r];
+            }
+            gathered_.resize(total);
+        }
+        MPI_Gatherv(result.localResult.data() + roundStart, count, MPI_INT,
+                    gathered_.data(), counts_.data(), displs_.data(), MPI_INT, 0, MPI_COMM_WORLD);
+        if (rank_ != 0) return;
+
+        double elapsedMs = (MPI_Wtime() - startTime_) * 1000.0;
+        if (found && !foundSent_) {
+            foundSent_ = true;
+            cout << "found vertex=" << targetVertex_ << " elapsed_ms=" << elapsedMs
+                 << " round=" << result.rounds << "\n";
+        }
+        for (int first = 0; first < total; first += chunkSize_) {
+            int last = min(total, first + chunkSize_);
+            cout << "chunk ";
+            for (int i = first; i < last; i++) {
+                cout << (i > first ? "," : "") << gathered_[i];
+            }
+            cout << "\n";
+        }
+        visited_ += total;
+        cout << "progress visited=" << visited_ << " elapsed_ms=" << elapsedMs
+             << " round=" << result.rounds << endl;
+    }
+
+private:
+    int rank_;
+    int chunkSize_;
+    int targetVertex_;
+    double startTime_;
+    long long visited_ = 0;
+    bool foundSent_ = false;
+    vector<int> counts_;
+    vector<int> displs_;
+    vector<int> gathered_;
+};
+
+// Comma separated ints, e.g. "1,2,3"
+bool parseIntList(const string& text, vector<int>& values) {
+    values.clear();
+    istringstream in(text);
+    string item;
+    while (getline(in, item, ',')) {
+        char* end = nullptr;
+        long value = strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0') return false;
+        values.push_back((int)value);
+    }
+    return !values.empty();
+}
+
+// Comma separated edges, e.g. "1:2,3:4", appended to updates
+bool parseEdgeList(const string& text, bool remove, vector<EdgeUpdate>& updates) {
+    istringstream in(text);
+    string item;
+    while (getline(in, item, ',')) {
+        char* end = nullptr;
+        long from = strtol(item.c_str(), &end, 10);
+        if (end == item.c_str() || *end != ':') return false;
+        const char* second = end + 1;
+        long to = strtol(second, &end, 10);
+        if (end == second || *end != '\0') return false;
+        updates.push_back({(int)from, (int)to, remove});
+    }
+    return !text.empty();
+}
+
+// Parse one request line on rank 0. Returns false (with reply filled in)
+// for lines that are answered without running anything. Batch queries go
+// to batchSources / batchTargets, edge updates to updates (deletions first).
+bool parseRequest(const string& line, int request[REQ_FIELDS], vector<int>& batchSources,
+                  vector<int>& batchTargets, vector<EdgeUpdate>& updates, string& reply) {
+    istringstream in(line);
+    string command;
+    in >> command;
+    if (command == "quit") {
+        request[REQ_COMMAND] = CMD_QUIT;
+        return true;
+    }
+    if (command == "ping") {
+        reply = "ok";
+        return false;
+    }
+    if (command == "stats") {
+        request[REQ_COMMAND] = CMD_STATS;
+        return true;
+    }
+    if (command == "run") {
+        request[REQ_COMMAND] = CMD_RUN;
+    } else if (command == "stream") {
+        request[REQ_COMMAND] = CMD_STREAM;
+    } else if (command == "reach") {
+        request[REQ_COMMAND] = CMD_REACH;
+    } else if (command == "batch") {
+        request[REQ_COMMAND] = CMD_BATCH;
+        batchSources.clear();
+        batchTargets.clear();
+    } else if (command == "update") {
+        request[REQ_COMMAND] = CMD_UPDATE;
+        updates.clear();
+    } else if (command == "forest") {
+        request[REQ_COMMAND] = CMD_FOREST;
+    } else {
+        reply = "error unknown command: " + command;
+        return false;
+    }
+
+    vector<EdgeUpdate> insertions;
+    string field;
+    while (in >> field) {
+        size_t eq = field.find('=');
+        string key = field.substr(0, eq);
+        if (request[REQ_COMMAND] == CMD_BATCH && (key == "targets" || key == "sources")) {
+            vector<int>& list = key == "targets" ? batchTargets : batchSources;
+            if (eq == string::npos || !parseIntList(field.substr(eq + 1), list)) {
+                reply = "error malformed field: " + field;
+                return false;
+            }
+            continue;
+        }
+        if (request[REQ_COMMAND] == CMD_UPDATE && (key == "insert" || key == "delete")) {
+            bool remove = key == "delete";
+            if (eq == string::npos || !parseEdgeList(field.substr(eq + 1), remove,
+                                                     remove ? updates : insertions)) {
+                reply = "error malformed field: " + field;
+                return false;
+            }
+            continue;
+        }
+        if (key == "mode" && (request[REQ_COMMAND] == CMD_RUN || request[REQ_COMMAND] == CMD_STREAM)) {
+            TraversalMode mode;
+            string name = eq == string::npos ? "" : field.substr(eq + 1);
+            if (name == "forest" && request[REQ_COMMAND] == CMD_RUN) {
+                request[REQ_MODE] = FOREST_MODE;
+            } else if (parseTraversalMode(name, mode)) {
+                request[REQ_MODE] = (int)mode;
+            } else {
+                reply = "error malformed field: " + field + " (mode is dfs, frontier or forest)";
+                return false;
+            }
+            continue;
+        }
+        char* end = nullptr;
+        long value = eq == string::npos ? 0 : strtol(field.c_str() + eq + 1, &end, 10);
+        if (eq == string::npos || *end != '\0') {
+            reply = "error malformed field: " + field;
+            return false;
+        }
+        if (key == "target") {
+            request[REQ_TARGET] = (int)value;
+        } else if (key == "source") {
+            request[REQ_SOURCE] = (int)value;
+        } else if (key == "chunk" && request[REQ_COMMAND] == CMD_STREAM) {
+            request[REQ_CHUNK] = (int)value;
+        } else if (key == "vertex" && request[REQ_COMMAND] == CMD_FOREST) {
+            request[REQ_VERTEX] = (int)value;
+        } else if (key == "vertices") {
+            if (value <= 0) {
+                reply = "error vertices must be positive";
+                return false;
+            }
+            request[REQ_VERTICES] = (int)value;
+        } else {
+            reply = "error unknown field: " + key;
+            return false;
+        }
+    }
+    if (request[REQ_COMMAND] == CMD_BATCH) {
+        if (batchTargets.empty()) {
+            reply = "error batch needs targets";
+            return false;
+        }
+        if (batchSources.size() > 1 && batchSources.size() != batchTargets.size()) {
+            reply = "error batch needs one source, or one per target";
+            return false;
+        }
+    }
+    if (request[REQ_COMMAND] == CMD_UPDATE) {
+        updates.insert(updates.end(), insertions.begin(), insertions.end());
+        if (updates.empty()) {
+            reply = "error update needs insert or delete";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    // Hybrid mode only calls MPI from the master thread
+    int threadSupport = MPI_THREAD_SINGLE;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &threadSupport);
+
+    int rank, numRanks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numRanks);
+
+    PartitionScheme scheme = PartitionScheme::Block;
+    if (argc >= 2 && !parsePartitionScheme(argv[1], scheme)) {
+        if (rank == 0) {
+            cerr << "unknown partition scheme: " << argv[1] << " (use block, bfs, rcm or lp)" << endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    int numThreads = argc >= 3 ? atoi(argv[2]) : 1;
+    if (numThreads < 1 || threadSupport < MPI_THREAD_FUNNELED) {
+        numThreads = 1;
+    }
+
+    int numVertices = 50000;
+    int defaultTarget = 42000;
+    int sourceVertex = 0;
+    if (const char* env = getenv("NUM_VERTICES")) numVertices = atoi(env);
+    if (const char* env = getenv("TARGET_VERTEX")) defaultTarget = atoi(env);
+
+    CSRGraph fileGraph;
+    const char* graphFile = graphFileFromEnv();
+    if (graphFile) {
+        string error;
+        if (!mapGraphFile(graphFile, fileGraph, error)) {
+            cerr << "rank " << rank << ": " << error << endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        numVertices = fileGraph.size();
+    }
+    MPI_Bcast(&numVertices, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&defaultTarget, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    DistributedGraph graph;
+    long long graphGeneration = 0;
+    // Every rank, built on the first frontier request; it refers to graph
+    unique_ptr<DistributedFrontier> frontier;
+    // Every rank: edge updates since the graph was loaded, and whether the
+    // partition predates some of them
+    EdgeOverlay overlay(numVertices);
+    bool residentStale = false;
+    int baseVertices = numVertices;
+    auto baseEdges = [&](int v, auto&& emit) {
+        if (graphFile) {
+            for (int u : fileGraph[v]) emit(u);
+        } else {
+            circulantEdges(baseVertices)(v, emit);
+        }
+    };
+    auto buildResident = [&](int n) {
+        frontier.reset();
+        baseVertices = n;
+        graph = partitionAndBuild(n, rank, numRanks, scheme, overlay.edges(baseEdges));
+        graphGeneration++;
+        residentStale = false;
+    };
+    buildResident(numVertices);
+    // Serial-mode visited stamps and stack, reset in O(1) by each run
+    TraversalContext context(graph.localSize());
+
+    // Rank 0 only
+    ResultCache<RunResult> cache;
+    unique_ptr<ReachabilityIndex> index;
+    unique_ptr<CSRGraph> generatedGraph;
+    unique_ptr<CSRGraph> updatedGraph;
+    unique_ptr<DynamicDFSForest> forest;
+    long long forestUpdates = 0;
+    long long forestMoved = 0;
+    vector<int> batchSources;
+    vector<int> batchTargets;
+    vector<EdgeUpdate> updates;
+    auto baseGraph = [&]() -> const CSRGraph& {
+        if (graphFile) return fileGraph;
+        if (!generatedGraph) generatedGraph.reset(new CSRGraph(createCirculantGraph(graph.totalVertices)));
+        return *generatedGraph;
+    };
+    auto fullGraph = [&]() -> const CSRGraph& {
+        if (overlay.empty()) return baseGraph();
+        if (!updatedGraph) {
+            updatedGraph.reset(new CSRGraph(buildGraph(graph.totalVertices, overlay.edges(csrEdges(baseGraph())))));
+        }
+        return *updatedGraph;
+    };
+    auto ensureForest = [&]() {
+        if (!forest) forest.reset(new DynamicDFSForest(baseGraph(), overlay));
+    };
+    auto answerForest = [&](int vertex) {
+        ensureForest();
+        cout << "ok components=" << forest->numComponents() << " reached=" << forest->componentSize(0)
+             << " updates=" << forestUpdates << " moved=" << forestMoved;
+        if (vertex >= 0 && vertex < graph.totalVertices) {
+            int root = forest->component(vertex);
+            cout << " parent=" << forest->parent(vertex) << " component=" << root
+                 << " component_size=" << forest->componentSize(root);
+        }
+        cout << endl;
+    };
+    // Vertex 0's tree is everything reachable from it
+    auto answerForestRun = [&](int source, int target) {
+        if (source != 0) {
+            cout << "error mode=forest answers source=0 only" << endl;
+            return;
+        }
+        double startTime = MPI_Wtime();
+        ensureForest();
+        bool found = target >= 0 && target < graph.totalVertices && forest->component(target) == 0;
+        double elapsed = MPI_Wtime() - startTime;
+        cout << "ok found=" << (found ? 1 : 0) << " visited=" << forest->componentSize(0)
+             << " runtime_ms=" << (elapsed * 1000.0) << " rounds=0 vertices=" << graph.totalVertices
+             << " target=" << target << " cached=0 mode=forest" << endl;
+    };
+    auto answerReach = [&](int source, int target) {
+        if (!index) {
+            index.reset(new ReachabilityIndex(fullGraph()));
+        }
+        bool inRange = source >= 0 && source < graph.totalVertices &&
+                       target >= 0 && target < graph.totalVertices;
+        cout << "ok reachable=" << (inRange && index->reachable(source, target) ? 1 : 0)
+             << " components=" << index->numComponents() << endl;
+    };
+    auto answerBatch = [&]() {
+        double startTime = MPI_Wtime();
+        BatchReachability batch = batchReachability(fullGraph(), batchSources, batchTargets);
+        double elapsed = MPI_Wtime() - startTime;
+        cout << "ok found=";
+        for (size_t q = 0; q < batch.found.size(); q++) {
+            cout << (q ? "," : "") << (int)batch.found[q];
+        }
+        cout << " reached=";
+        for (size_t q = 0; q < batch.reachedCount.size(); q++) {
+            cout << (q ? "," : "") << batch.reachedCount[q];
+        }
+        cout << " runtime_ms=" << (elapsed * 1000.0) << " sweeps=" << batch.sweeps << endl;
+    };
+
+    if (rank == 0) {
+        cout << "ready vertices=" << graph.totalVertices << endl;
+    }
+
+    while (true) {
+        int request[REQ_FIELDS] = {CMD_QUIT, graph.totalVertices, defaultTarget, sourceVertex,
+                                   DEFAULT_CHUNK, (int)TraversalMode::DFS, -1};
+        if (rank == 0) {
+            string line;
+            string reply;
+            while (getline(cin, line)) {
+                request[REQ_VERTICES] = graph.totalVertices;
+                request[REQ_TARGET] = defaultTarget;
+                request[REQ_SOURCE] = sourceVertex;
+                request[REQ_CHUNK] = DEFAULT_CHUNK;
+                request[REQ_MODE] = (int)TraversalMode::DFS;
+                request[REQ_VERTEX] = -1;
+                if (line.empty()) continue;
+                if (!parseRequest(line, request, batchSources, batchTargets, updates, reply)) {
+                    cout << reply << endl;
+                    continue;
+                }
+                int command = request[REQ_COMMAND];
+                if (command == CMD_QUIT) break;
+                if (command == CMD_STATS) {
+                    cout << "ok cache_hits=" << cache.hits() << " cache_misses=" << cache.misses()
+                         << " index_fallbacks=" << (index ? index->fallbackQueries() : 0) << endl;
+                    continue;
+                }
+                if (graphFile && request[REQ_VERTICES] != graph.totalVertices) {
+                    cout << "error graph file has " << graph.totalVertices << " vertices" << endl;
+                    continue;
+                }
+                if (command == CMD_UPDATE) {
+                    bool inRange = true;
+                    for (const EdgeUpdate& update : updates) {
+                        inRange &= update.from >= 0 && update.from < request[REQ_VERTICES] &&
+                                   update.to >= 0 && update.to < request[REQ_VERTICES];
+                    }
+                    if (!inRange) {
+                        cout << "error update has a vertex outside 0.." << request[REQ_VERTICES] - 1 << endl;
+                        continue;
+                    }
+                    // Every rank applies it
+                    break;
+                }
+                // A different size needs the other ranks to rebuild
+                if (request[REQ_VERTICES] != graph.totalVertices) break;
+
+                int target = request[REQ_TARGET];
+                int source = request[REQ_SOURCE];
+                if (command == CMD_REACH) {
+                    answerReach(source, target);
+                    continue;
+                }
+                if (command == CMD_BATCH) {
+                    answerBatch();
+                    continue;
+                }
+                if (command == CMD_FOREST) {
+                    answerForest(request[REQ_VERTEX]);
+                    continue;
+                }
+                if (command == CMD_STREAM) break;
+                int mode = request[REQ_MODE];
+                if (mode == FOREST_MODE) {
+                    answerForestRun(source, target);
+                    continue;
+                }
+                const RunResult* hit = cache.find(QueryKey(graphGeneration, source, target, mode));
+                if (!hit) break;
+                cout << "ok found=" << (hit->found ? 1 : 0) << " visited=" << hit->visited
+                     << " runtime_ms=" << hit->runtimeMs << " rounds=" << hit->rounds
+                     << " vertices=" << graph.totalVertices << " target=" << target
+                     << " cached=1 mode=" << traversalModeName((TraversalMode)mode) << endl;
+            }
+            if (!cin) request[REQ_COMMAND] = CMD_QUIT;
+        }
+        MPI_Bcast(request, REQ_FIELDS, MPI_INT, 0, MPI_COMM_WORLD);
+        if (request[REQ_COMMAND] == CMD_QUIT) break;
+
+        if (request[REQ_VERTICES] != graph.totalVertices) {
+            // Updates were to the old graph
+            overlay.reset(request[REQ_VERTICES]);
+            forest.reset();
+            forestUpdates = forestMoved = 0;
+            updatedGraph.reset();
+            buildResident(request[REQ_VERTICES]);
+            cache.clear();
+            index.reset();
+            generatedGraph.reset();
+        }
+        if (request[REQ_COMMAND] == CMD_UPDATE) {
+            int count = updates.size();
+            MPI_Bcast(&count, 1, MPI_INT, 0, MPI_COMM_WORLD);
+            vector<int> packed(3 * count);
+            if (rank == 0) {
+                for (int i = 0; i < count; i++) {
+                    packed[3 * i] = updates[i].from;
+                    packed[3 * i + 1] = updates[i].to;
+                    packed[3 * i + 2] = updates[i].remove;
+                }
+            }
+            MPI_Bcast(packed.data(), 3 * count, MPI_INT, 0, MPI_COMM_WORLD);
+            updates.resize(count);
+            for (int i = 0; i < count; i++) {
+                updates[i] = {packed[3 * i], packed[3 * i + 1], packed[3 * i + 2] != 0};
+            }
+
+            // Rank 0 updates the overlay through the forest; every rank
+            // sees the same changes, since all start from the same graph
+            double startTime = MPI_Wtime();
+            ForestUpdateStats stats;
+            if (rank == 0) {
+                ensureForest();
+                stats = forest->apply(updates);
+            } else {
+                for (const EdgeUpdate& update : updates) {
+                    if (!overlay.apply(baseEdges, update)) stats.ignored++;
+                }
+            }
+            double elapsed = MPI_Wtime() - startTime;
+            if (stats.ignored < count) {
+                residentStale = true;
+                graphGeneration++;
+                if (rank == 0) {
+                    cache.clear();
+                    index.reset();
+                    updatedGraph.reset();
+                }
+            }
+            if (rank == 0) {
+                forestUpdates += count - stats.ignored;
+                forestMoved += stats.moved;
+                cout << "ok inserted=" << stats.inserted << " deleted=" << stats.deleted
+                     << " ignored=" << stats.ignored << " moved=" << stats.moved
+                     << " components=" << forest->numComponents() << " reached=" << forest->componentSize(0)
+                     << " runtime_ms=" << (elapsed * 1000.0) << endl;
+            }
+            continue;
+        }
+        // Rank-0 queries only get here when the graph had to be rebuilt first
+        if (request[REQ_COMMAND] == CMD_REACH) {
+            if (rank == 0) answerReach(request[REQ_SOURCE], request[REQ_TARGET]);
+            continue;
+        }
+        if (request[REQ_COMMAND] == CMD_BATCH) {
+            if (rank == 0) answerBatch();
+            continue;
+        }
+        if (request[REQ_COMMAND] == CMD_FOREST) {
+            if (rank == 0) answerForest(request[REQ_VERTEX]);
+            continue;
+        }
+        if (request[REQ_MODE] == FOREST_MODE && request[REQ_COMMAND] == CMD_RUN) {
+            if (rank == 0) answerForestRun(request[REQ_SOURCE], request[REQ_TARGET]);
+            continue;
+        }
+        // The traversals run on the partition, which must include the updates
+        if (residentStale) buildResident(graph.totalVertices);
+        int targetVertex = request[REQ_TARGET];
+        int source = request[REQ_SOURCE];
+        // Streams need the preorder, so they always run the DFS
+        TraversalMode mode = request[REQ_COMMAND] == CMD_STREAM ? TraversalMode::DFS
+                                                                : (TraversalMode)request[REQ_MODE];
+        if (mode == TraversalMode::Frontier && !frontier) {
+            frontier.reset(new DistributedFrontier(graph));
+        }
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        double startTime = MPI_Wtime();
+
+        DistributedDFSResult dfsResult;
+        long long localCount = 0;
+        if (mode == TraversalMode::Frontier) {
+            DistributedFrontierResult reached = frontier->run(source, targetVertex, numThreads);
+            dfsResult.found = reached.found;
+            dfsResult.rounds = reached.levels;
+            localCount = reached.localVisited;
+        } else if (request[REQ_COMMAND] == CMD_STREAM) {
+            StreamingObserver observer(graph.domain, request[REQ_CHUNK], targetVertex, startTime);
+            dfsResult = numThreads > 1
+                ? dfs_mpi_hybrid(graph, source, targetVertex, numThreads, observer)
+                : dfs_mpi_with_overlap(graph, source, targetVertex, context, observer);
+        } else {
+            dfsResult = numThreads > 1
+                ? dfs_mpi_hybrid(graph, source, targetVertex, numThreads)
+                : dfs_mpi_with_overlap(graph, source, targetVertex, context);
+        }
+
+        double localTime = MPI_Wtime() - startTime;
+        double maxTime = 0;
+        MPI_Reduce(&localTime, &maxTime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+        if (mode == TraversalMode::DFS) localCount = dfsResult.localResult.size();
+        long long totalCount = 0;
+        MPI_Reduce(&localCount, &totalCount, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+        if (rank == 0) {
+            RunResult result = {dfsResult.found, (int)totalCount, maxTime * 1000.0, dfsResult.rounds};
+            cache.insert(QueryKey(graphGeneration, source, targetVertex, (int)mode), result);
+            cout << "ok found=" << (result.found ? 1 : 0) << " visited=" << result.visited
+                 << " runtime_ms=" << result.runtimeMs << " rounds=" << result.rounds
+                 << " vertices=" << graph.totalVertices << " target=" << targetVertex
+                 << " cached=0 mode=" << traversalModeName(mode) << endl;
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
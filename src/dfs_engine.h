@@ -0,0 +1,280 @@
+#ifndef DFS_ENGINE_H
+#define DFS_ENGINE_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "graph.h"
+#include "neighbor_filter.h"
+
+// One vertex on the explicit DFS stack; next is the position of the next
+// neighbor to examine, counted in traversal order (see stridedIndex).
+// listSize >= 0 marks a prefiltered frame: it walks a block of its row's
+// unvisited neighbors (listNext of listSize consumed) kept in DFSStack, and
+// next is where the following block starts.
+struct DFSFrame {
+    int vertex;
+    int next;
+    int listSize = -1;
+    int listNext = 0;
+};
+
+// Frame buffer reused across traversals so repeated DFS calls do not
+// reallocate; depth is bounded by heap size rather than the call stack.
+// filtered holds one PREFILTER_SLOT block per open prefiltered frame, in
+// stack order, so the top frame's block is always last.
+struct DFSStack {
+    std::vector<DFSFrame> frames;
+    std::vector<int> filtered;
+    std::vector<int> remote;
+};
+
+// Single-threaded visited set that resets in O(1): v is visited when
+// stamps[v] equals the current epoch, so starting a new traversal only
+// bumps the epoch (the array is cleared once every 2^32 - 1 resets, when
+// the counter wraps). Four bytes per vertex, and a block of neighbors is
+// tested with one gather (see neighbor_filter.h).
+class EpochVisited {
+public:
+    explicit EpochVisited(size_t numVertices = 0) : stamps_(numVertices, 0) {}
+
+    size_t size() const { return stamps_.size(); }
+
+    bool test(int v) const { return stamps_[v] == epoch_; }
+    void set(int v) { stamps_[v] = epoch_; }
+
+    // Forget every mark; vertices added by a resize start unvisited
+    void reset(size_t numVertices) {
+        if (numVertices != stamps_.size()) stamps_.resize(numVertices, 0);
+        if (++epoch_ == 0) {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            epoch_ = 1;
+        }
+    }
+
+    // Unvisited neighbors to localOut; ids past size() (ghosts) to remoteOut
+    FilterCounts filterUnvisited(const int* nbrs, int count, int* localOut, int* remoteOut) const {
+        return filterNeighbors(nbrs, count, 0, stamps_.size(), stamps_.data(), epoch_,
+                               localOut, remoteOut);
+    }
+
+private:
+    std::vector<uint32_t> stamps_;
+    uint32_t epoch_ = 1;
+};
+
+// Everything a serial traversal needs, kept across traversals of the same
+// graph so that repeated runs neither allocate nor clear O(V) state:
+// begin() bumps the visited epoch and empties result, whose capacity
+// (reserved for every vertex up front) and the stack's survive.
+struct TraversalContext {
+    EpochVisited visited;
+    DFSStack stack;
+    std::vector<int> result;
+
+    explicit TraversalContext(int numVertices = 0) : visited(numVertices) {
+        result.reserve(numVertices);
+    }
+
+    void begin(int numVertices) {
+        visited.reset(numVertices);
+        result.clear();
+        if (result.capacity() < (size_t)numVertices) result.reserve(numVertices);
+    }
+};
+
+// Rows at least this long are filtered in bulk, PREFILTER_BLOCK at a time
+const int PREFILTER_MIN_DEGREE = 256;
+const int PREFILTER_BLOCK = 256;
+const int PREFILTER_SLOT = PREFILTER_BLOCK + NEIGHBOR_FILTER_SLACK;
+
+// Position in adj[v] of the k-th neighbor in the two-pass stride order:
+// first indices 0, stride, 2*stride, ..., then every index not divisible
+// by stride in increasing order. stride <= 1 is plain adjacency order.
+inline int stridedIndex(int k, int degree, int stride) {
+    if (stride <= 1) {
+        return k;
+    }
+    int firstPass = (degree + stride - 1) / stride;
+    if (k < firstPass) {
+        return k * stride;
+    }
+    int j = k - firstPass;
+    return j + j / (stride - 1) + 1;
+}
+
+// The traversal kernels are specialized at compile time on these policies
+// instead of branching on them per neighbor.
+//
+// Neighbor order: the row position of the k-th neighbor to examine, and
+// whether rows may be bulk-filtered (which only keeps plain order).
+struct PlainOrder {
+    static const bool prefilter = true;
+    int index(int k, int) const { return k; }
+};
+
+struct StridedOrder {
+    static const bool prefilter = false;
+    int stride;
+    int index(int k, int degree) const { return stridedIndex(k, degree, stride); }
+};
+
+// Visit actions, run when a vertex is first marked; true stops the traversal
+struct CollectVisit {
+    std::vector<int>& out;
+    bool operator()(int v) const {
+        out.push_back(v);
+        return false;
+    }
+};
+
+struct CountVisit {
+    long long& count;
+    bool operator()(int) const {
+        count++;
+        return false;
+    }
+};
+
+struct SearchVisit {
+    int target;
+    bool& found;
+    bool operator()(int v) const {
+        if (v != target) return false;
+        found = true;
+        return true;
+    }
+};
+
+// Per-vertex work hooks: the synthetic load the drivers put on every
+// visited vertex, or nothing
+inline void syntheticWork(int v) {
+    double work = 0;
+    for (int i = 0; i < 1000; i++) {
+        work += (v * i) % 100;
+    }
+}
+
+struct SyntheticWork {
+    void operator()(int v) const { syntheticWork(v); }
+};
+
+struct NoWork {
+    void operator()(int) const {}
+};
+
+// An action followed by a work hook, unless the action stops the traversal
+template <typename Action, typename Work>
+struct VisitWith {
+    Action action;
+    Work work;
+    bool operator()(int v) {
+        if (action(v)) return true;
+        work(v);
+        return false;
+    }
+};
+
+template <typename Work, typename Action>
+VisitWith<Action, Work> visitWith(Action action, Work work = Work()) {
+    return {action, work};
+}
+
+struct FollowAll {
+    bool operator()(int) const { return true; }
+};
+
+// Non-recursive preorder DFS from root in the neighbor order of the Order
+// policy, producing the same order as the recursive dfsRec kernels.
+// visit(v) runs when v is first marked and may return true to stop the
+// whole traversal (the function then returns true). follow(u) filters
+// which neighbors are eligible at all; neighbors it rejects are never
+// marked or descended into.
+//
+// visited is an EpochVisited (or anything with size, test, set and
+// filterUnvisited). Rows of at least PREFILTER_MIN_DEGREE neighbors (in
+// PlainOrder) are scanned a block at a time with one vectorized pass that
+// drops the neighbors already visited, since nothing unmarks them; the
+// survivors are still rechecked one by one, as the subtrees in between
+// may visit them.
+// A block is only filtered once the previous one is used up, so returning
+// to a hub after a deep subtree skips everything that subtree marked.
+// Neighbors outside visited's range (ghosts) cannot be descended into and
+// go to follow when their block is filtered.
+template <typename Order, typename Visited, typename Visit, typename Follow>
+bool orderedDFS(const CSRGraph& adj, Visited& visited, int root, Order order,
+                DFSStack& stack, Visit& visit, Follow& follow) {
+    if (visited.test(root)) return false;
+
+    std::vector<DFSFrame>& frames = stack.frames;
+    std::vector<int>& filtered = stack.filtered;
+    frames.clear();
+    filtered.clear();
+    if (stack.remote.size() < (size_t)PREFILTER_SLOT) stack.remote.resize(PREFILTER_SLOT);
+
+    auto open = [&](int v) {
+        if (!Order::prefilter || adj.degree(v) < PREFILTER_MIN_DEGREE) {
+            frames.push_back({v, 0});
+            return;
+        }
+        filtered.resize(filtered.size() + PREFILTER_SLOT);
+        frames.push_back({v, 0, 0, 0});
+    };
+
+    visited.set(root);
+    if (visit(root)) return true;
+    open(root);
+
+    while (!frames.empty()) {
+        DFSFrame& top = frames.back();
+        int degree = adj.degree(top.vertex);
+        int u;
+        if (top.listSize >= 0) {
+            int* list = filtered.data() + filtered.size() - PREFILTER_SLOT;
+            while (top.listNext == top.listSize && top.next < degree) {
+                int count = std::min(PREFILTER_BLOCK, degree - top.next);
+                FilterCounts counts = visited.filterUnvisited(adj[top.vertex].begin() + top.next, count,
+                                                              list, stack.remote.data());
+                top.next += count;
+                top.listSize = counts.local;
+                top.listNext = 0;
+                for (int i = 0; i < counts.remote; i++) follow(stack.remote[i]);
+            }
+            if (top.listNext == top.listSize) {
+                filtered.resize(filtered.size() - PREFILTER_SLOT);
+                frames.pop_back();
+                continue;
+            }
+            u = list[top.listNext++];
+        } else {
+            if (top.next == degree) {
+                frames.pop_back();
+                continue;
+            }
+            u = adj[top.vertex][order.index(top.next++, degree)];
+        }
+        if (!follow(u) || visited.test(u)) continue;
+
+        visited.set(u);
+        if (visit(u)) {
+            frames.clear();
+            return true;
+        }
+        open(u);
+    }
+    return false;
+}
+
+// orderedDFS with the order picked from stride: PlainOrder for stride <= 1,
+// else StridedOrder. The choice is made once per root, not per neighbor.
+template <typename Visited, typename Visit, typename Follow = FollowAll>
+bool iterativeDFS(const CSRGraph& adj, Visited& visited, int root,
+                  int stride, DFSStack& stack, Visit visit,
+                  Follow follow = Follow()) {
+    if (stride > 1) {
+        return orderedDFS(adj, visited, root, StridedOrder{stride}, stack, visit, follow);
+    }
+    return orderedDFS(adj, visited, root, PlainOrder(), stack, visit, follow);
+}
+
+#endif
@@ -0,0 +1,526 @@
+#ifndef DISTRIBUTED_DFS_H
+#define DISTRIBUTED_DFS_H
+
+#include <vector>
+#include <atomic>
+#include <mpi.h>
+#include "graph.h"
+#include "dfs_engine.h"
+#include "distributed_graph.h"
+#include "atomic_bitmap.h"
+#include "work_stealing_dfs.h"
+#include "preorder_buffers.h"
+#include "phase_trace.h"
+#include "checkpoint.h"
+
+// Cluster-wide stop once the target is found. The rank that finds it sends
+// one int on STOP_TAG to every other rank; the others poll a receive that
+// is pre-posted for the whole traversal, but only every pollInterval visits
+// so the check stays cheap. Only the target's owner can ever send, so every
+// other rank receives at most one message.
+class StopSignal {
+public:
+    static const int STOP_TAG = 2;
+
+    StopSignal(const DomainInfo& domain, int pollInterval = 64)
+        : domain_(domain), pollInterval_(pollInterval < 1 ? 1 : pollInterval) {
+        MPI_Irecv(&recvFlag_, 1, MPI_INT, MPI_ANY_SOURCE, STOP_TAG, MPI_COMM_WORLD, &recvReq_);
+    }
+
+    bool stopped() const { return sent_ || received_; }
+
+    // Called by the rank that found the target
+    void broadcast() {
+        if (sent_) return;
+        sent_ = true;
+        for (int destRank = 0; destRank < domain_.numRanks; destRank++) {
+            if (destRank != domain_.rank) {
+                MPI_Request req;
+                MPI_Isend(&sendFlag_, 1, MPI_INT, destRank, STOP_TAG, MPI_COMM_WORLD, &req);
+                sendRequests_.push_back(req);
+            }
+        }
+    }
+
+    // True once another rank has announced the target
+    bool poll() {
+        if (received_) return true;
+        if (++sinceLastPoll_ < pollInterval_) return false;
+        sinceLastPoll_ = 0;
+        int flag = 0;
+        MPI_Test(&recvReq_, &flag, MPI_STATUS_IGNORE);
+        received_ = flag != 0;
+        return received_;
+    }
+
+    // Complete all outstanding requests. globallyFound must be the agreed
+    // result of the traversal: if some other rank found the target its
+    // message is guaranteed to arrive and is waited for; otherwise nothing
+    // can be in flight and the pre-posted receive is cancelled.
+    void finish(bool globallyFound) {
+        if (!received_) {
+            if (globallyFound && !sent_) {
+                MPI_Wait(&recvReq_, MPI_STATUS_IGNORE);
+                received_ = true;
+            } else {
+                MPI_Cancel(&recvReq_);
+                MPI_Wait(&recvReq_, MPI_STATUS_IGNORE);
+            }
+        }
+        if (!sendRequests_.empty()) {
+            MPI_Waitall(sendRequests_.size(), sendRequests_.data(), MPI_STATUSES_IGNORE);
+            sendRequests_.clear();
+        }
+    }
+
+private:
+    DomainInfo domain_;
+    int pollInterval_;
+    int sinceLastPoll_ = 0;
+    int sendFlag_ = 1;
+    int recvFlag_ = 0;
+    bool sent_ = false;
+    bool received_ = false;
+    MPI_Request recvReq_;
+    std::vector<MPI_Request> sendRequests_;
+};
+
+// Ghosts to forward to their owners, as indices into the halo table. The
+// bitmap keeps each ghost from being queued twice in one traversal: once
+// sent, its owner visits it, so sending it again could only repeat work.
+// take() hands out the ghosts queued since the last call.
+class GhostOutbox {
+public:
+    explicit GhostOutbox(int numGhosts) : marked_((numGhosts + 63) / 64, 0) {}
+
+    void insert(int ghost) {
+        uint64_t bit = uint64_t(1) << (ghost & 63);
+        uint64_t& word = marked_[ghost >> 6];
+        if (word & bit) return;
+        word |= bit;
+        queued_.push_back(ghost);
+    }
+
+    size_t size() const { return queued_.size(); }
+
+    void take(std::vector<int>& ghosts) {
+        ghosts.swap(queued_);
+        queued_.clear();
+    }
+
+    // For checkpoints: every ghost ever queued, and the ones still queued
+    const std::vector<uint64_t>& marked() const { return marked_; }
+    const std::vector<int>& queued() const { return queued_; }
+
+    void restore(const std::vector<uint64_t>& marked, const std::vector<int>& queued) {
+        marked_ = marked;
+        queued_ = queued;
+    }
+
+private:
+    std::vector<uint64_t> marked_;
+    std::vector<int> queued_;
+};
+
+// DFS over the local partition starting at local id vertex. Ghost
+// neighbors are not followed; they are collected in outbox for their
+// owners. visited covers the owned ids
+// only, so the bulk filter of a hub row also splits off its ghosts.
+// Finding the target, or hearing that another rank found it, ends the
+// traversal.
+inline bool localDFS(const DistributedGraph& graph, EpochVisited& visited, DFSStack& stack,
+                     int vertex, std::vector<int>& localResult,
+                     GhostOutbox& outbox, int targetLocal, bool& found,
+                     StopSignal& stop) {
+
+    auto visit = [&](int v) {
+        int globalId = graph.toGlobal(v);
+        localResult.push_back(globalId);
+
+        if (v == targetLocal) {
+            found = true;
+            stop.broadcast();
+            return true;
+        }
+        if (stop.poll()) {
+            found = true;
+            return true;
+        }
+
+        syntheticWork(globalId);
+        return false;
+    };
+
+    auto follow = [&](int neighbor) {
+        if (!graph.isGhost(neighbor)) {
+            return true;
+        }
+        outbox.insert(neighbor - graph.localSize());
+        return false;
+    };
+
+    return orderedDFS(graph.local, visited, vertex, PlainOrder(), stack, visit, follow);
+}
+
+struct DistributedDFSResult {
+    std::vector<int> localResult;   // global ids of this rank's visited vertices
+    bool found = false;             // target found (on any rank)
+    int rounds = 0;                 // exchange rounds until quiescence
+};
+
+// One single-threaded localDFS per pending vertex. The visited stamps and
+// stack come from context, which a caller running many traversals on the
+// same partition (the daemon) keeps between them; construction resets it
+// in O(1).
+class SerialPartitionTraversal {
+public:
+    SerialPartitionTraversal(const DistributedGraph& graph, int targetLocal, StopSignal& stop,
+                             TraversalContext& context)
+        : graph_(graph), visited_(context.visited), stack_(context.stack),
+          targetLocal_(targetLocal), stop_(stop) {
+        visited_.reset(graph.localSize());
+    }
+
+    bool isVisited(int v) const { return visited_.test(v); }
+    void markVisited(int v) { visited_.set(v); }
+
+    void traverse(const std::vector<int>& pending, GhostOutbox& outbox,
+                  std::vector<int>& localResult, bool& found) {
+        for (int v : pending) {
+            if (found) break;
+            if (!visited_.test(v)) {
+                localDFS(graph_, visited_, stack_, v, localResult, outbox, targetLocal_, found, stop_);
+            }
+        }
+    }
+
+private:
+    const DistributedGraph& graph_;
+    EpochVisited& visited_;
+    DFSStack& stack_;
+    int targetLocal_;
+    StopSignal& stop_;
+};
+
+// All threads of the rank traverse the pending vertices together with the
+// work-stealing engine. Ghost neighbors go to per-thread outboxes that the
+// master merges after the parallel region. Only the master thread (the one
+// that called MPI_Init_thread) touches MPI, so MPI_THREAD_FUNNELED is
+// enough: it polls the StopSignal, and broadcasts once the region is over
+// if one of the threads found the target.
+class HybridPartitionTraversal {
+public:
+    HybridPartitionTraversal(const DistributedGraph& graph, int targetLocal, StopSignal& stop,
+                             int numThreads)
+        : graph_(graph), visited_(graph.localSize()), targetLocal_(targetLocal), stop_(stop),
+          engine_(numThreads), buffers_(engine_.numThreads()), outboxes_(engine_.numThreads()) {}
+
+    bool isVisited(int v) const { return visited_.test(v); }
+    void markVisited(int v) { visited_.tryClaim(v); }
+
+    void traverse(const std::vector<int>& pending, GhostOutbox& outbox,
+                  std::vector<int>& localResult, bool& found) {
+        if (found || pending.empty()) return;
+        std::atomic<bool> targetHit{false};
+        std::atomic<bool> stopHeard{false};
+        buffers_.clear();
+
+        auto visit = [&](int v, int parent, int tid) {
+            int globalId = graph_.toGlobal(v);
+            buffers_.append(tid, globalId, parent);
+
+            if (v == targetLocal_) {
+                targetHit.store(true, std::memory_order_relaxed);
+                engine_.requestStop();
+                return;
+            }
+            if (tid == 0 && stop_.poll()) {
+                stopHeard.store(true, std::memory_order_relaxed);
+                engine_.requestStop();
+                return;
+            }
+
+            syntheticWork(globalId);
+        };
+
+        auto follow = [&](int neighbor, int tid) {
+            if (!graph_.isGhost(neighbor)) {
+                return true;
+            }
+            outboxes_[tid].push_back(neighbor - graph_.localSize());
+            return false;
+        };
+
+        engine_.runFrom(graph_.local, visited_, pending, 1, visit, follow);
+
+        for (int tid = 0; tid < buffers_.numThreads(); tid++) {
+            for (const PreorderEntry& e : buffers_.buffer(tid)) localResult.push_back(e.vertex);
+        }
+        for (std::vector<int>& box : outboxes_) {
+            for (int ghost : box) outbox.insert(ghost);
+            box.clear();
+        }
+        if (targetHit.load()) {
+            stop_.broadcast();
+            found = true;
+        } else if (stopHeard.load()) {
+            found = true;
+        }
+    }
+
+    int numThreads() const { return engine_.numThreads(); }
+
+private:
+    const DistributedGraph& graph_;
+    AtomicBitmap visited_;
+    int targetLocal_;
+    StopSignal& stop_;
+    WorkStealingDFS engine_;
+    ThreadLocalPreorder buffers_;
+    std::vector<std::vector<int>> outboxes_;
+};
+
+// Ghost ids that ride inline with each per-neighbor header of a round's
+// exchange; a neighbor's excess goes in a second, exact-size exchange. The
+// 1 KB block is latency-bound like an exact-size message of that size, so
+// the padding costs little while small rounds need a single collective.
+const int HALO_INLINE_IDS = 255;
+const int HALO_BLOCK = 1 + HALO_INLINE_IDS;   // count, then the first ids
+
+// Distributed reachability DFS from source. Each rank traverses its own
+// vertices and forwards newly discovered remote vertices to their owners;
+// this repeats in rounds until no rank has pending work.
+//
+// The exchange runs on the partition's halo topology, so a rank only
+// talks to the ranks it shares cut edges with: one fixed-size block per
+// neighbor, the vertex count followed by up to HALO_INLINE_IDS vertex ids,
+// sent with a non-blocking neighborhood alltoall. Sizes and data thus
+// travel in the same message and the cost per round grows with the number
+// of partition neighbors rather than with the number of ranks.
+//
+// Round r overlaps two things: the exchange of the vertices discovered in
+// round r - 1 and the traversal of the vertices received in round r - 1.
+// After the exchange completes, a non-blocking allreduce of (vertices
+// still to send + vertices just received, target found, some block
+// overflowed) decides whether another round is needed, and whether the
+// ids that did not fit inline follow in a neighborhood alltoallv. Since
+// every message of a round is complete before the check, a zero pending
+// sum means no work is queued anywhere and none is in flight. A StopSignal
+// additionally cuts the current round short on every rank as soon as the
+// target is found, instead of at the next check.
+//
+// Traversal is SerialPartitionTraversal or HybridPartitionTraversal.
+// observer(result, roundStart, found) runs on every rank after each round's
+// termination check; result.localResult[roundStart..] are the vertices
+// this rank visited in that round. Since all ranks see the same rounds it
+// may use collectives (the daemon streams results that way).
+//
+// With a trace, every phase of every round is timestamped into it. With a
+// checkpoint, the traversal first resumes from the newest checkpoint all
+// ranks share, if any, and saves one after every round in which some
+// rank found one due (the termination check carries the vote, so all
+// ranks save the same round).
+template <typename Traversal, typename RoundObserver>
+DistributedDFSResult runExchangeRounds(const DistributedGraph& graph, int source,
+                                       Traversal& traversal, StopSignal& stop,
+                                       RoundObserver& observer, PhaseTrace* trace = nullptr,
+                                       TraversalCheckpoint* checkpoint = nullptr) {
+    const HaloTopology& halo = *graph.halo;
+    int numSources = halo.sources.size();
+    int numDestinations = halo.destinations.size();
+    DistributedDFSResult result;
+    bool targetFound = false;
+
+    // outbox: ghosts found by the last traversal, not yet sent
+    // pending: local ids received from other ranks, not yet traversed
+    GhostOutbox outbox(graph.numGhosts());
+    std::vector<int> pending, sending;
+    if (graph.ownedLocalId(source) >= 0) {
+        pending.push_back(graph.ownedLocalId(source));
+    }
+    CheckpointImage image;
+    if (checkpoint && checkpoint->restore(image)) {
+        result.rounds = image.round;
+        result.localResult.swap(image.localResult);
+        pending.swap(image.pending);
+        outbox.restore(image.markedGhosts, image.queuedGhosts);
+        for (int v = 0; v < graph.localSize(); v++) {
+            if ((image.visited[v >> 6] >> (v & 63)) & 1) traversal.markVisited(v);
+        }
+    }
+
+    std::vector<std::vector<int>> sendBuffers(numDestinations);
+    std::vector<int> sendBlocks(numDestinations * HALO_BLOCK);
+    std::vector<int> recvBlocks(numSources * HALO_BLOCK);
+    std::vector<int> overflowSend, overflowRecv;
+    std::vector<int> overflowSendCounts(numDestinations), overflowSendOffsets(numDestinations);
+    std::vector<int> overflowRecvCounts(numSources), overflowRecvOffsets(numSources);
+
+    auto queueReceived = [&](const int* ids, int count) {
+        for (int i = 0; i < count; i++) {
+            int localId = graph.ownedLocalId(ids[i]);
+            if (localId >= 0 && !traversal.isVisited(localId)) {
+                pending.push_back(localId);
+            }
+        }
+    };
+
+    while (true) {
+        result.rounds++;
+        size_t roundStart = result.localResult.size();
+        int round = result.rounds;
+
+        double phase = phaseStart(trace);
+        outbox.take(sending);
+        for (std::vector<int>& buffer : sendBuffers) buffer.clear();
+        for (int g : sending) {
+            sendBuffers[halo.ghostDestination[g]].push_back(graph.ghostGlobal[g]);
+        }
+
+        bool overflowing = false;
+        for (int i = 0; i < numDestinations; i++) {
+            int count = sendBuffers[i].size();
+            int* block = &sendBlocks[i * HALO_BLOCK];
+            block[0] = count;
+            std::copy(sendBuffers[i].begin(), sendBuffers[i].begin() + std::min(count, HALO_INLINE_IDS),
+                      block + 1);
+            overflowing = overflowing || count > HALO_INLINE_IDS;
+        }
+        MPI_Request exchangeReq;
+        MPI_Ineighbor_alltoall(sendBlocks.data(), HALO_BLOCK, MPI_INT, recvBlocks.data(), HALO_BLOCK,
+                               MPI_INT, halo.comm, &exchangeReq);
+        phaseEnd(trace, TracePhase::PackSends, round, phase, sending.size());
+
+        // Traverse last round's arrivals while this round's blocks move
+        phase = phaseStart(trace);
+        traversal.traverse(pending, outbox, result.localResult, targetFound);
+        phaseEnd(trace, TracePhase::Traverse, round, phase, pending.size());
+        pending.clear();
+
+        phase = phaseStart(trace);
+        MPI_Wait(&exchangeReq, MPI_STATUS_IGNORE);
+        phaseEnd(trace, TracePhase::WaitExchange, round, phase);
+
+        int received = 0;
+        for (int j = 0; j < numSources; j++) {
+            int count = recvBlocks[j * HALO_BLOCK];
+            received += count;
+            overflowing = overflowing || count > HALO_INLINE_IDS;
+        }
+
+        int localState[4] = {(int)outbox.size() + received, targetFound ? 1 : 0, overflowing ? 1 : 0,
+                             checkpoint && checkpoint->due() ? 1 : 0};
+        int globalState[4] = {0, 0, 0, 0};
+        MPI_Request checkReq;
+        MPI_Iallreduce(localState, globalState, 4, MPI_INT, MPI_SUM, MPI_COMM_WORLD, &checkReq);
+
+        phase = phaseStart(trace);
+        for (int j = 0; j < numSources; j++) {
+            const int* block = &recvBlocks[j * HALO_BLOCK];
+            queueReceived(block + 1, std::min(block[0], HALO_INLINE_IDS));
+        }
+        phaseEnd(trace, TracePhase::QueueReceived, round, phase, received);
+
+        phase = phaseStart(trace);
+        MPI_Wait(&checkReq, MPI_STATUS_IGNORE);
+        phaseEnd(trace, TracePhase::WaitTermination, round, phase);
+
+        // Every rank agrees on the overflow, so all of them join the alltoallv
+        if (globalState[1] == 0 && globalState[2] > 0) {
+            phase = phaseStart(trace);
+            overflowSend.clear();
+            for (int i = 0; i < numDestinations; i++) {
+                overflowSendOffsets[i] = overflowSend.size();
+                if ((int)sendBuffers[i].size() > HALO_INLINE_IDS) {
+                    overflowSend.insert(overflowSend.end(), sendBuffers[i].begin() + HALO_INLINE_IDS,
+                                        sendBuffers[i].end());
+                }
+                overflowSendCounts[i] = overflowSend.size() - overflowSendOffsets[i];
+            }
+            int total = 0;
+            for (int j = 0; j < numSources; j++) {
+                overflowRecvOffsets[j] = total;
+                overflowRecvCounts[j] = std::max(0, recvBlocks[j * HALO_BLOCK] - HALO_INLINE_IDS);
+                total += overflowRecvCounts[j];
+            }
+            overflowRecv.resize(total);
+            MPI_Neighbor_alltoallv(overflowSend.data(), overflowSendCounts.data(),
+                                   overflowSendOffsets.data(), MPI_INT, overflowRecv.data(),
+                                   overflowRecvCounts.data(), overflowRecvOffsets.data(), MPI_INT,
+                                   halo.comm);
+            queueReceived(overflowRecv.data(), total);
+            phaseEnd(trace, TracePhase::Overflow, round, phase, total);
+        }
+
+        // Traversals that end this round have nothing left to resume
+        bool last = globalState[1] > 0 || globalState[0] == 0;
+        if (checkpoint && globalState[3] > 0 && !last) {
+            phase = phaseStart(trace);
+            image.round = round;
+            image.localResult = result.localResult;
+            image.pending = pending;
+            image.queuedGhosts = outbox.queued();
+            image.markedGhosts = outbox.marked();
+            image.visited.assign((graph.localSize() + 63) / 64, 0);
+            for (int v = 0; v < graph.localSize(); v++) {
+                if (traversal.isVisited(v)) image.visited[v >> 6] |= uint64_t(1) << (v & 63);
+            }
+            checkpoint->save(std::move(image));
+            phaseEnd(trace, TracePhase::Checkpoint, round, phase, result.localResult.size());
+        }
+
+        phase = phaseStart(trace);
+        observer(result, roundStart, globalState[1] > 0);
+        phaseEnd(trace, TracePhase::Observer, round, phase);
+        if (globalState[1] > 0) {
+            result.found = true;
+            break;
+        }
+        if (globalState[0] == 0) {
+            break;
+        }
+    }
+
+    stop.finish(result.found);
+    if (checkpoint) checkpoint->complete();
+    return result;
+}
+
+struct NoRoundObserver {
+    void operator()(const DistributedDFSResult&, size_t, bool) const {}
+};
+
+template <typename RoundObserver = NoRoundObserver>
+DistributedDFSResult dfs_mpi_with_overlap(const DistributedGraph& graph, int source, int target,
+                                          TraversalContext& context,
+                                          RoundObserver observer = RoundObserver(),
+                                          PhaseTrace* trace = nullptr,
+                                          TraversalCheckpoint* checkpoint = nullptr) {
+    StopSignal stop(graph.domain);
+    SerialPartitionTraversal traversal(graph, graph.ownedLocalId(target), stop, context);
+    return runExchangeRounds(graph, source, traversal, stop, observer, trace, checkpoint);
+}
+
+template <typename RoundObserver = NoRoundObserver>
+DistributedDFSResult dfs_mpi_with_overlap(const DistributedGraph& graph, int source, int target,
+                                          RoundObserver observer = RoundObserver(),
+                                          PhaseTrace* trace = nullptr,
+                                          TraversalCheckpoint* checkpoint = nullptr) {
+    TraversalContext context;
+    return dfs_mpi_with_overlap(graph, source, target, context, observer, trace, checkpoint);
+}
+
+// Hybrid MPI + OpenMP: one rank per node (or socket) holds the partition
+// once and numThreads threads traverse it. The MPI library must provide at
+// least MPI_THREAD_FUNNELED.
+template <typename RoundObserver = NoRoundObserver>
+DistributedDFSResult dfs_mpi_hybrid(const DistributedGraph& graph, int source, int target,
+                                    int numThreads, RoundObserver observer = RoundObserver(),
+                                    PhaseTrace* trace = nullptr,
+                                    TraversalCheckpoint* checkpoint = nullptr) {
+    StopSignal stop(graph.domain);
+    HybridPartitionTraversal traversal(graph, graph.ownedLocalId(target), stop, numThreads);
+    return runExchangeRounds(graph, source, traversal, stop, observer, trace, checkpoint);
+}
+
+#endif
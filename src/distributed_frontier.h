@@ -0,0 +1,286 @@
+#ifndef DISTRIBUTED_FRONTIER_H
+#define DISTRIBUTED_FRONTIER_H
+
+#include <vector>
+#include <cstdint>
+#include <omp.h>
+#include <mpi.h>
+#include "graph.h"
+#include "atomic_bitmap.h"
+#include "distributed_graph.h"
+#include "frontier_reach.h"
+
+struct DistributedFrontierResult {
+    bool found = false;
+    long long localVisited = 0;     // vertices this rank reached
+    int levels = 0;
+    int bottomUpLevels = 0;
+};
+
+// The FrontierReach traversal over a partitioned graph, exchanging over
+// the partition's halo topology after every level. The two directions
+// move different data:
+//
+// - top-down: frontier vertices claim their local out-neighbors and send
+//   each ghost out-neighbor's id to its owner once per traversal, like
+//   the DFS exchange rounds;
+// - bottom-up: every rank sends its neighbors one bit per boundary vertex
+//   with edges into them, saying whether it is in the frontier, and each
+//   rank checks its unvisited vertices against local and remote in-
+//   neighbors. The bitmap size is fixed by the partition, so the exchange
+//   costs the same every level however large the frontier is.
+//
+// The constructor builds the in-edges of every owned vertex, remote ones
+// included, with one exchange, so keep the object for the life of the
+// graph (the daemon does). Collective, as is run().
+class DistributedFrontier {
+public:
+    explicit DistributedFrontier(const DistributedGraph& graph)
+        : graph_(graph), halo_(*graph.halo),
+          visited_(graph.localSize()), frontier_(graph.localSize()), next_(graph.localSize()),
+          ghostSent_(graph.numGhosts()) {
+        int localSize = graph.localSize();
+        int numDestinations = halo_.destinations.size();
+        int numSources = halo_.sources.size();
+
+        // Boundary vertices with an edge into each destination, in local id
+        // order, and those edges as (index in that list, target global id)
+        boundarySend_.resize(numDestinations);
+        std::vector<std::vector<int>> edgePairs(numDestinations);
+        for (int v : graph.boundaryLocal) {
+            for (int u : graph.local[v]) {
+                if (!graph.isGhost(u)) continue;
+                int d = halo_.ghostDestination[u - localSize];
+                std::vector<int>& list = boundarySend_[d];
+                if (list.empty() || list.back() != v) list.push_back(v);
+                edgePairs[d].push_back(list.size() - 1);
+                edgePairs[d].push_back(graph.ghostGlobal[u - localSize]);
+            }
+        }
+
+        std::vector<int> sendSizes(numDestinations * 2), recvSizes(numSources * 2);
+        for (int d = 0; d < numDestinations; d++) {
+            sendSizes[2 * d] = boundarySend_[d].size();
+            sendSizes[2 * d + 1] = edgePairs[d].size();
+        }
+        MPI_Neighbor_alltoall(sendSizes.data(), 2, MPI_INT, recvSizes.data(), 2, MPI_INT, halo_.comm);
+
+        std::vector<int> pairSend, pairSendCounts(numDestinations), pairSendOffsets(numDestinations);
+        for (int d = 0; d < numDestinations; d++) {
+            pairSendOffsets[d] = pairSend.size();
+            pairSend.insert(pairSend.end(), edgePairs[d].begin(), edgePairs[d].end());
+            pairSendCounts[d] = edgePairs[d].size();
+        }
+        std::vector<int> pairRecvCounts(numSources), pairRecvOffsets(numSources);
+        int pairTotal = 0;
+        for (int s = 0; s < numSources; s++) {
+            pairRecvOffsets[s] = pairTotal;
+            pairRecvCounts[s] = recvSizes[2 * s + 1];
+            pairTotal += pairRecvCounts[s];
+        }
+        std::vector<int> pairRecv(pairTotal);
+        MPI_Neighbor_alltoallv(pairSend.data(), pairSendCounts.data(), pairSendOffsets.data(), MPI_INT,
+                               pairRecv.data(), pairRecvCounts.data(), pairRecvOffsets.data(), MPI_INT,
+                               halo_.comm);
+
+        // Frontier bitmaps: one run of words per neighbor, bit k for the
+        // k-th boundary vertex of the list above
+        bitsSendCounts_.resize(numDestinations);
+        bitsSendOffsets_.resize(numDestinations);
+        int words = 0;
+        for (int d = 0; d < numDestinations; d++) {
+            bitsSendOffsets_[d] = words;
+            bitsSendCounts_[d] = (boundarySend_[d].size() + 63) / 64;
+            words += bitsSendCounts_[d];
+        }
+        bitsSend_.resize(words);
+        bitsRecvCounts_.resize(numSources);
+        bitsRecvOffsets_.resize(numSources);
+        words = 0;
+        for (int s = 0; s < numSources; s++) {
+            bitsRecvOffsets_[s] = words;
+            bitsRecvCounts_[s] = (recvSizes[2 * s] + 63) / 64;
+            words += bitsRecvCounts_[s];
+        }
+        remoteFrontier_.resize(words);
+
+        // In-neighbors: local id, or localSize + bit index in remoteFrontier_
+        std::vector<std::vector<int>> in(localSize);
+        for (int v = 0; v < localSize; v++) {
+            for (int u : graph.local[v]) {
+                if (!graph.isGhost(u)) in[u].push_back(v);
+            }
+        }
+        for (int s = 0; s < numSources; s++) {
+            for (int i = pairRecvOffsets[s]; i < pairRecvOffsets[s] + pairRecvCounts[s]; i += 2) {
+                int u = graph.ownedLocalId(pairRecv[i + 1]);
+                if (u >= 0) in[u].push_back(localSize + bitsRecvOffsets_[s] * 64 + pairRecv[i]);
+            }
+        }
+        reverse_ = buildGraph(localSize, [&](int u, auto&& emit) {
+            for (int w : in[u]) emit(w);
+        });
+
+        long long localEdges = graph.local.numEdges();
+        MPI_Allreduce(&localEdges, &totalEdges_, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    }
+
+    DistributedFrontierResult run(int source, int target, int numThreads = 1) {
+        numThreads_ = numThreads < 1 ? 1 : numThreads;
+        DistributedFrontierResult result;
+        visited_.clear();
+        frontier_.clear();
+        ghostSent_.clear();
+
+        // frontier size, its out-edges, target reached
+        long long local[3] = {0, 0, 0};
+        int sourceLocal = graph_.ownedLocalId(source);
+        int targetLocal = graph_.ownedLocalId(target);
+        if (sourceLocal >= 0) {
+            visited_.tryClaim(sourceLocal);
+            frontier_.tryClaim(sourceLocal);
+            local[0] = 1;
+            local[1] = graph_.local.degree(sourceLocal);
+            local[2] = source == target;
+        }
+        long long global[3] = {0, 0, 0};
+        MPI_Allreduce(local, global, 3, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        result.localVisited = local[0];
+        long long unexploredEdges = totalEdges_ - global[1];
+        FrontierDirection direction;
+
+        while (global[0] > 0 && global[2] == 0) {
+            direction.next(global[0], global[1], unexploredEdges, graph_.totalVertices);
+            next_.clear();
+            long long nextSize = 0, nextEdges = 0;
+            bool hit = false;
+            if (direction.bottomUp) {
+                bottomUpStep(targetLocal, nextSize, nextEdges, hit);
+                result.bottomUpLevels++;
+            } else {
+                topDownStep(targetLocal, nextSize, nextEdges, hit);
+            }
+            result.levels++;
+            result.localVisited += nextSize;
+            frontier_.swap(next_);
+
+            local[0] = nextSize;
+            local[1] = nextEdges;
+            local[2] = hit;
+            MPI_Allreduce(local, global, 3, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+            unexploredEdges -= global[1];
+        }
+        result.found = global[2] > 0;
+        return result;
+    }
+
+    // Owned vertices reached by the last run, by local id
+    const AtomicBitmap& visited() const { return visited_; }
+
+private:
+    void addToNext(int u, int targetLocal, long long& size, long long& edges, bool& hit) {
+        next_.tryClaim(u);
+        size++;
+        edges += graph_.local.degree(u);
+        if (u == targetLocal) hit = true;
+    }
+
+    void topDownStep(int targetLocal, long long& nextSize, long long& nextEdges, bool& hit) {
+        int localSize = graph_.localSize();
+        std::vector<std::vector<int>> ghosts(numThreads_);
+        long long numWords = frontier_.numWords();
+        #pragma omp parallel for schedule(dynamic, 16) num_threads(numThreads_) \
+            reduction(+:nextSize, nextEdges) reduction(||:hit)
+        for (long long w = 0; w < numWords; w++) {
+            std::vector<int>& sent = ghosts[omp_get_thread_num()];
+            for (uint64_t bits = frontier_.word(w); bits; bits &= bits - 1) {
+                int v = w * 64 + __builtin_ctzll(bits);
+                for (int u : graph_.local[v]) {
+                    if (graph_.isGhost(u)) {
+                        if (ghostSent_.tryClaim(u - localSize)) sent.push_back(u - localSize);
+                    } else if (visited_.tryClaim(u)) {
+                        addToNext(u, targetLocal, nextSize, nextEdges, hit);
+                    }
+                }
+            }
+        }
+
+        int numDestinations = halo_.destinations.size();
+        int numSources = halo_.sources.size();
+        std::vector<std::vector<int>> buffers(numDestinations);
+        for (const std::vector<int>& sent : ghosts) {
+            for (int g : sent) buffers[halo_.ghostDestination[g]].push_back(graph_.ghostGlobal[g]);
+        }
+        std::vector<int> sendCounts(numDestinations), sendOffsets(numDestinations), send;
+        for (int d = 0; d < numDestinations; d++) {
+            sendOffsets[d] = send.size();
+            sendCounts[d] = buffers[d].size();
+            send.insert(send.end(), buffers[d].begin(), buffers[d].end());
+        }
+        std::vector<int> recvCounts(numSources), recvOffsets(numSources);
+        MPI_Neighbor_alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, halo_.comm);
+        int total = 0;
+        for (int s = 0; s < numSources; s++) {
+            recvOffsets[s] = total;
+            total += recvCounts[s];
+        }
+        std::vector<int> recv(total);
+        MPI_Neighbor_alltoallv(send.data(), sendCounts.data(), sendOffsets.data(), MPI_INT,
+                               recv.data(), recvCounts.data(), recvOffsets.data(), MPI_INT, halo_.comm);
+        for (int id : recv) {
+            int u = graph_.ownedLocalId(id);
+            if (u >= 0 && visited_.tryClaim(u)) addToNext(u, targetLocal, nextSize, nextEdges, hit);
+        }
+    }
+
+    // Words of the unvisited set are split between threads as in
+    // FrontierReach; the remote frontier is read-only during the scan
+    void bottomUpStep(int targetLocal, long long& nextSize, long long& nextEdges, bool& hit) {
+        std::fill(bitsSend_.begin(), bitsSend_.end(), 0);
+        for (size_t d = 0; d < boundarySend_.size(); d++) {
+            uint64_t* bits = bitsSend_.data() + bitsSendOffsets_[d];
+            const std::vector<int>& list = boundarySend_[d];
+            for (size_t k = 0; k < list.size(); k++) {
+                if (frontier_.test(list[k])) bits[k / 64] |= uint64_t(1) << (k % 64);
+            }
+        }
+        MPI_Neighbor_alltoallv(bitsSend_.data(), bitsSendCounts_.data(), bitsSendOffsets_.data(),
+                               MPI_UINT64_T, remoteFrontier_.data(), bitsRecvCounts_.data(),
+                               bitsRecvOffsets_.data(), MPI_UINT64_T, halo_.comm);
+
+        int localSize = graph_.localSize();
+        long long numWords = visited_.numWords();
+        #pragma omp parallel for schedule(dynamic, 16) num_threads(numThreads_) \
+            reduction(+:nextSize, nextEdges) reduction(||:hit)
+        for (long long w = 0; w < numWords; w++) {
+            for (uint64_t bits = ~visited_.word(w); bits; bits &= bits - 1) {
+                int v = w * 64 + __builtin_ctzll(bits);
+                if (v >= localSize) break;
+                for (int p : reverse_[v]) {
+                    bool inFrontier = p < localSize
+                        ? frontier_.test(p)
+                        : (remoteFrontier_[(p - localSize) / 64] >> ((p - localSize) % 64)) & 1;
+                    if (!inFrontier) continue;
+                    visited_.tryClaim(v);
+                    addToNext(v, targetLocal, nextSize, nextEdges, hit);
+                    break;
+                }
+            }
+        }
+    }
+
+    const DistributedGraph& graph_;
+    const HaloTopology& halo_;
+    int numThreads_ = 1;
+    long long totalEdges_ = 0;
+    CSRGraph reverse_;
+    AtomicBitmap visited_;
+    AtomicBitmap frontier_;
+    AtomicBitmap next_;
+    AtomicBitmap ghostSent_;
+    std::vector<std::vector<int>> boundarySend_;
+    std::vector<uint64_t> bitsSend_, remoteFrontier_;
+    std::vector<int> bitsSendCounts_, bitsSendOffsets_, bitsRecvCounts_, bitsRecvOffsets_;
+};
+
+#endif
@@ -0,0 +1,296 @@
+#ifndef DISTRIBUTED_GRAPH_H
+#define DISTRIBUTED_GRAPH_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mpi.h>
+#include "graph.h"
+#include "partitioner.h"
+
+struct DomainInfo {
+    int rank;
+    int numRanks;
+    int startVertex;
+    int endVertex;
+    int localSize;
+};
+
+inline DomainInfo setupDomain(int totalVertices, int rank, int numRanks) {
+    DomainInfo domain;
+    domain.rank = rank;
+    domain.numRanks = numRanks;
+
+    int baseSize = totalVertices / numRanks;
+    int remainder = totalVertices % numRanks;
+
+    if (rank < remainder) {
+        domain.localSize = baseSize + 1;
+        domain.startVertex = rank * domain.localSize;
+    } else {
+        domain.localSize = baseSize;
+        domain.startVertex = remainder * (baseSize + 1) + (rank - remainder) * baseSize;
+    }
+
+    domain.endVertex = domain.startVertex + domain.localSize;
+
+    return domain;
+}
+
+inline bool isLocalVertex(int vertex, const DomainInfo& domain) {
+    return vertex >= domain.startVertex && vertex < domain.endVertex;
+}
+
+inline int findOwnerRank(int vertex, int totalVertices, int numRanks) {
+    int baseSize = totalVertices / numRanks;
+    int remainder = totalVertices % numRanks;
+
+    int threshold = remainder * (baseSize + 1);
+    if (vertex < threshold) {
+        return vertex / (baseSize + 1);
+    } else {
+        return remainder + (vertex - threshold) / baseSize;
+    }
+}
+
+// The ranks a partition exchanges ghosts with, as an MPI distributed graph
+// topology for the neighborhood collectives: this rank sends to the owners
+// of its ghosts (destinations) and receives from the ranks that have one
+// of its vertices as a ghost (sources), in the order of comm. Shared by all
+// copies of a DistributedGraph; the communicator is freed with the last
+// one, unless MPI has already been finalized.
+struct HaloTopology {
+    MPI_Comm comm = MPI_COMM_NULL;
+    std::vector<int> sources;
+    std::vector<int> destinations;
+    std::vector<int> destinationIndex;  // rank -> index in destinations, or -1
+    std::vector<int> ghostDestination;  // ghost index -> index in destinations
+
+    HaloTopology() = default;
+    HaloTopology(const HaloTopology&) = delete;
+    HaloTopology& operator=(const HaloTopology&) = delete;
+
+    ~HaloTopology() {
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if (!finalized && comm != MPI_COMM_NULL) MPI_Comm_free(&comm);
+    }
+};
+
+// The part of a graph stored on one rank: adjacency rows for the vertices
+// the rank owns, with neighbors renumbered to local ids. Local id
+// i < localSize() is the i-th owned vertex; local id localSize() + g is
+// ghost g, a remote neighbor whose global id and owner are kept in the
+// halo table. Memory per rank is O(V/P + E/P + ghosts).
+//
+// Ownership is either the 1D block range of domain or comes from a
+// partitioner's vertex -> rank table (tableOwnership). The table is only
+// needed while building: afterwards the owned vertices are listed in
+// ownedGlobal and the ghosts' owners in ghostOwner, and domain's vertex
+// range fields are not meaningful.
+struct DistributedGraph {
+    DomainInfo domain;
+    int totalVertices = 0;
+    bool tableOwnership = false;
+    std::vector<int> ownedGlobal;   // sorted owned global ids (table ownership only)
+    CSRGraph local;                 // local.size() == domain.localSize
+    std::vector<int> ghostGlobal;   // sorted global ids of remote neighbors
+    std::vector<int> ghostOwner;    // owning rank of each ghost
+    std::vector<int> boundaryLocal; // sorted local ids of owned vertices with a ghost neighbor
+    int64_t cutEdges = 0;           // local edges to ghosts
+    std::shared_ptr<const HaloTopology> halo;   // set by partitionAndBuild
+
+    int localSize() const { return domain.localSize; }
+    int numGhosts() const { return ghostGlobal.size(); }
+    bool isGhost(int localId) const { return localId >= domain.localSize; }
+
+    int toGlobal(int localId) const {
+        if (localId >= domain.localSize) return ghostGlobal[localId - domain.localSize];
+        return tableOwnership ? ownedGlobal[localId] : domain.startVertex + localId;
+    }
+
+    // Local id of an owned global vertex, or -1 if another rank owns it
+    int ownedLocalId(int globalId) const {
+        if (tableOwnership) {
+            auto it = std::lower_bound(ownedGlobal.begin(), ownedGlobal.end(), globalId);
+            return it != ownedGlobal.end() && *it == globalId ? it - ownedGlobal.begin() : -1;
+        }
+        return isLocalVertex(globalId, domain) ? globalId - domain.startVertex : -1;
+    }
+
+    bool isBoundary(int localId) const {
+        return std::binary_search(boundaryLocal.begin(), boundaryLocal.end(), localId);
+    }
+
+    size_t memoryBytes() const {
+        return local.offsets.size() * sizeof(int64_t) + local.neighbors.size() * sizeof(int) +
+               (ownedGlobal.size() + ghostGlobal.size() + ghostOwner.size() + boundaryLocal.size()) *
+                   sizeof(int);
+    }
+};
+
+// Fill local and the halo table of a graph whose ownership is already set;
+// ownerOf(v) names the rank owning any global vertex
+template <typename EdgeGenerator, typename OwnerOf>
+void buildPartitionRows(DistributedGraph& graph, EdgeGenerator& gen, OwnerOf ownerOf) {
+    int localSize = graph.localSize();
+
+    for (int i = 0; i < localSize; i++) {
+        gen(graph.toGlobal(i), [&](int u) {
+            if (graph.ownedLocalId(u) < 0) graph.ghostGlobal.push_back(u);
+        });
+    }
+    std::sort(graph.ghostGlobal.begin(), graph.ghostGlobal.end());
+    graph.ghostGlobal.erase(std::unique(graph.ghostGlobal.begin(), graph.ghostGlobal.end()),
+                            graph.ghostGlobal.end());
+    graph.ghostGlobal.shrink_to_fit();
+
+    graph.ghostOwner.resize(graph.ghostGlobal.size());
+    for (size_t g = 0; g < graph.ghostGlobal.size(); g++) {
+        graph.ghostOwner[g] = ownerOf(graph.ghostGlobal[g]);
+    }
+
+    const std::vector<int>& ghosts = graph.ghostGlobal;
+    graph.local = buildGraph(localSize, [&](int i, auto&& emit) {
+        gen(graph.toGlobal(i), [&](int u) {
+            int localId = graph.ownedLocalId(u);
+            if (localId >= 0) {
+                emit(localId);
+            } else {
+                int g = std::lower_bound(ghosts.begin(), ghosts.end(), u) - ghosts.begin();
+                emit(localSize + g);
+            }
+        });
+    });
+
+    // Boundary / interior split, fixed for the life of the partition
+    for (int v = 0; v < localSize; v++) {
+        bool boundary = false;
+        for (int u : graph.local[v]) {
+            if (graph.isGhost(u)) {
+                graph.cutEdges++;
+                boundary = true;
+            }
+        }
+        if (boundary) graph.boundaryLocal.push_back(v);
+    }
+    graph.boundaryLocal.shrink_to_fit();
+}
+
+// Build this rank's block partition from a global edge generator (the same
+// gen(v, emit) contract as buildGraph), generating only the owned rows.
+template <typename EdgeGenerator>
+DistributedGraph buildDistributedGraph(int totalVertices, const DomainInfo& domain,
+                                       EdgeGenerator gen) {
+    DistributedGraph graph;
+    graph.domain = domain;
+    graph.totalVertices = totalVertices;
+    buildPartitionRows(graph, gen, [&](int v) {
+        return findOwnerRank(v, totalVertices, domain.numRanks);
+    });
+    return graph;
+}
+
+// Same, with ownership taken from a partitioner's table. The graph keeps
+// no reference to the table, so the caller can free it afterwards.
+template <typename EdgeGenerator>
+DistributedGraph buildDistributedGraph(int totalVertices, int rank, const Partition& partition,
+                                       EdgeGenerator gen) {
+    DistributedGraph graph;
+    graph.totalVertices = totalVertices;
+    graph.tableOwnership = true;
+    for (int v = 0; v < totalVertices; v++) {
+        if (partition.owner[v] == rank) graph.ownedGlobal.push_back(v);
+    }
+    graph.ownedGlobal.shrink_to_fit();
+    graph.domain.rank = rank;
+    graph.domain.numRanks = partition.numRanks;
+    graph.domain.localSize = graph.ownedGlobal.size();
+    graph.domain.startVertex = graph.domain.endVertex = -1;
+    buildPartitionRows(graph, gen, [&](int v) { return partition.owner[v]; });
+    return graph;
+}
+
+// Collective: every rank names the owners of its ghosts and MPI works out
+// who sends to whom
+inline std::shared_ptr<const HaloTopology> buildHaloTopology(const DistributedGraph& graph,
+                                                             MPI_Comm comm = MPI_COMM_WORLD) {
+    std::vector<int> owners(graph.ghostOwner);
+    std::sort(owners.begin(), owners.end());
+    owners.erase(std::unique(owners.begin(), owners.end()), owners.end());
+
+    auto halo = std::make_shared<HaloTopology>();
+    int self = graph.domain.rank;
+    int degree = owners.size();
+    // Some MPIs reject a null destination array even for degree 0
+    MPI_Dist_graph_create(comm, 1, &self, &degree, owners.empty() ? &self : owners.data(),
+                          MPI_UNWEIGHTED, MPI_INFO_NULL, 0, &halo->comm);
+
+    int inDegree = 0, outDegree = 0, weighted = 0;
+    MPI_Dist_graph_neighbors_count(halo->comm, &inDegree, &outDegree, &weighted);
+    halo->sources.resize(inDegree);
+    halo->destinations.resize(outDegree);
+    MPI_Dist_graph_neighbors(halo->comm, inDegree, halo->sources.data(), MPI_UNWEIGHTED,
+                             outDegree, halo->destinations.data(), MPI_UNWEIGHTED);
+    halo->destinationIndex.assign(graph.domain.numRanks, -1);
+    for (int i = 0; i < outDegree; i++) halo->destinationIndex[halo->destinations[i]] = i;
+    halo->ghostDestination.resize(graph.numGhosts());
+    for (int g = 0; g < graph.numGhosts(); g++) {
+        halo->ghostDestination[g] = halo->destinationIndex[graph.ghostOwner[g]];
+    }
+    return halo;
+}
+
+// Build this rank's partition with the chosen scheme. Block ownership needs
+// no global information; other schemes partition the full graph on rank 0
+// once and broadcast the ownership table. So while building, lp/bfs/rcm
+// cost memory proportional to the vertex count on every rank (the table,
+// 4 bytes per vertex) and the whole graph on rank 0; both are freed before
+// returning, leaving O(V/P + E/P + ghosts) per rank as with block.
+// Collective, since it also sets up the halo topology.
+template <typename EdgeGenerator>
+DistributedGraph partitionAndBuild(int totalVertices, int rank, int numRanks,
+                                   PartitionScheme scheme, EdgeGenerator gen,
+                                   MPI_Comm comm = MPI_COMM_WORLD) {
+    DistributedGraph graph;
+    if (scheme == PartitionScheme::Block) {
+        graph = buildDistributedGraph(totalVertices, setupDomain(totalVertices, rank, numRanks), gen);
+    } else {
+        Partition partition;
+        if (rank == 0) {
+            CSRGraph full = buildGraph(totalVertices, gen);
+            partition = computePartition(full, numRanks, scheme);
+        } else {
+            partition.numRanks = numRanks;
+            partition.owner.resize(totalVertices);
+        }
+        MPI_Bcast(partition.owner.data(), totalVertices, MPI_INT, 0, comm);
+        graph = buildDistributedGraph(totalVertices, rank, partition, gen);
+    }
+    graph.halo = buildHaloTopology(graph, comm);
+    return graph;
+}
+
+// Edge-cut and balance of a distributed graph, reduced over all ranks
+inline PartitionStats gatherPartitionStats(const DistributedGraph& graph, MPI_Comm comm = MPI_COMM_WORLD) {
+    // cut edges, total edges, boundary vertices
+    long long local[3] = {graph.cutEdges, (long long)graph.local.numEdges(),
+                          (long long)graph.boundaryLocal.size()};
+
+    long long global[3] = {0, 0, 0};
+    MPI_Allreduce(local, global, 3, MPI_LONG_LONG, MPI_SUM, comm);
+    int size = graph.localSize();
+    PartitionStats stats;
+    MPI_Allreduce(&size, &stats.minPartSize, 1, MPI_INT, MPI_MIN, comm);
+    MPI_Allreduce(&size, &stats.maxPartSize, 1, MPI_INT, MPI_MAX, comm);
+
+    stats.edgeCut = global[0];
+    stats.totalEdges = global[1];
+    stats.boundaryVertices = global[2];
+    double average = double(graph.totalVertices) / graph.domain.numRanks;
+    stats.imbalance = average > 0 ? stats.maxPartSize / average : 1.0;
+    return stats;
+}
+
+#endif
@@ -0,0 +1,433 @@
+#ifndef DYNAMIC_FOREST_H
+#define DYNAMIC_FOREST_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include "graph.h"
+#include "dfs_engine.h"
+
+// One edge insertion or deletion
+struct EdgeUpdate {
+    int from;
+    int to;
+    bool remove;
+};
+
+// Edge changes layered over an immutable base graph, given as an edge
+// generator (see buildGraph), so a mapped or generated graph takes updates
+// without being copied. Edges are a set: inserting an edge that exists or
+// deleting one that doesn't changes nothing, and a deletion removes every
+// copy of the edge.
+class EdgeOverlay {
+public:
+    explicit EdgeOverlay(int numVertices = 0) { reset(numVertices); }
+
+    void reset(int numVertices) {
+        modified_.assign(numVertices, 0);
+        added_.clear();
+        addedIn_.clear();
+        removed_.clear();
+    }
+
+    bool empty() const { return added_.empty() && removed_.empty(); }
+
+    bool removed(int from, int to) const {
+        return modified_[from] && removed_.count(key(from, to)) != 0;
+    }
+
+    // Inserted edges out of / into v, nullptr if none
+    const std::vector<int>* addedOut(int v) const { return find(added_, v); }
+    const std::vector<int>* addedIn(int v) const { return find(addedIn_, v); }
+
+    template <typename Edges>
+    bool hasEdge(Edges&& base, int from, int to) const {
+        if (const std::vector<int>* out = addedOut(from)) {
+            if (std::find(out->begin(), out->end(), to) != out->end()) return true;
+        }
+        bool found = false;
+        base(from, [&](int u) { found |= u == to; });
+        return found && !removed(from, to);
+    }
+
+    // Both return false if they changed nothing. Inserted edges never
+    // duplicate a live base edge: re-inserting a deleted base edge just
+    // forgets the deletion.
+    template <typename Edges>
+    bool insert(Edges&& base, int from, int to) {
+        if (hasEdge(base, from, to)) return false;
+        modified_[from] = 1;
+        if (removed_.erase(key(from, to))) return true;
+        added_[from].push_back(to);
+        addedIn_[to].push_back(from);
+        return true;
+    }
+
+    template <typename Edges>
+    bool remove(Edges&& base, int from, int to) {
+        if (!hasEdge(base, from, to)) return false;
+        modified_[from] = 1;
+        if (erase(added_, from, to)) {
+            erase(addedIn_, to, from);
+        } else {
+            removed_.insert(key(from, to));
+        }
+        return true;
+    }
+
+    template <typename Edges>
+    bool apply(Edges&& base, const EdgeUpdate& update) {
+        return update.remove ? remove(base, update.from, update.to)
+                             : insert(base, update.from, update.to);
+    }
+
+    // Generator for the updated graph, for buildGraph or partitionAndBuild.
+    // Refers to this overlay, which must not change while it is in use.
+    template <typename Edges>
+    auto edges(Edges base) const {
+        return [this, base](int v, auto&& emit) {
+            if (!modified_[v]) {
+                base(v, emit);
+                return;
+            }
+            base(v, [&](int u) {
+                if (!removed_.count(key(v, u))) emit(u);
+            });
+            if (const std::vector<int>* out = addedOut(v)) {
+                for (int u : *out) emit(u);
+            }
+        };
+    }
+
+private:
+    typedef std::unordered_map<int, std::vector<int>> EdgeLists;
+
+    static uint64_t key(int from, int to) { return (uint64_t(uint32_t(from)) << 32) | uint32_t(to); }
+
+    static const std::vector<int>* find(const EdgeLists& lists, int v) {
+        auto it = lists.find(v);
+        return it == lists.end() ? nullptr : &it->second;
+    }
+
+    static bool erase(EdgeLists& lists, int v, int u) {
+        auto it = lists.find(v);
+        if (it == lists.end()) return false;
+        std::vector<int>& list = it->second;
+        auto pos = std::find(list.begin(), list.end(), u);
+        if (pos == list.end()) return false;
+        list.erase(pos);
+        if (list.empty()) lists.erase(it);
+        return true;
+    }
+
+    std::vector<char> modified_;    // vertices with any inserted or deleted out-edge
+    EdgeLists added_;
+    EdgeLists addedIn_;
+    std::unordered_set<uint64_t> removed_;
+};
+
+struct ForestUpdateStats {
+    int inserted = 0;
+    int deleted = 0;
+    int ignored = 0;        // insertions of existing edges, deletions of missing ones
+    long long moved = 0;    // vertices that changed place in the forest
+};
+
+// A DFS forest of the whole graph, kept up to date while edges come and
+// go instead of being recomputed. It starts as the forest of the dfs()
+// outer loop (roots tried in order 0, 1, ...). Each vertex has a parent, a
+// component (the root of its tree) and an entry and exit time. The times
+// are labels on an Euler tour kept as a linked list, so subtrees can be
+// cut and spliced without renumbering the rest.
+//
+// After updates it is a valid DFS forest for some order of roots, not
+// necessarily the outer loop's: no edge u -> v has v entered after u
+// exited. Vertex 0's tree always comes first, so it is exactly the set of
+// vertices reachable from vertex 0. Other trees need not match what a
+// fresh dfs() would build: repairs keep every vertex they don't have to
+// move where it is, so a vertex the outer loop would make a root can end
+// up inside a later tree (and the number of trees can differ).
+//
+// - Inserting u -> v only breaks that rule if v was entered after u exited.
+//   The DFS would then have reached v from u, together with everything
+//   reachable from v through vertices entered after u exited. Those
+//   vertices (whole subtrees, as tree edges lead to later vertices) move
+//   under u as its last child; no other edge can become invalid.
+// - Deleting a non-tree edge changes nothing. Deleting the tree edge
+//   p -> c cuts c's subtree off and appends it as the last tree, which
+//   only breaks the edges into it from outside. Each of those still broken
+//   is repaired like an insertion, earliest exit time first.
+//
+// Either way the work is the moved subtrees' edges (and the in-edges of a
+// cut subtree), not the graph. Labels are respaced locally when a gap runs
+// out. Single-threaded; the overlay is updated through apply().
+class DynamicDFSForest {
+public:
+    DynamicDFSForest(const CSRGraph& base, EdgeOverlay& overlay)
+        : base_(base), reverse_(transposeGraph(base)), overlay_(overlay) {
+        build();
+    }
+
+    DynamicDFSForest(const DynamicDFSForest&) = delete;
+    DynamicDFSForest& operator=(const DynamicDFSForest&) = delete;
+
+    int numVertices() const { return numVertices_; }
+    int parent(int v) const { return parent_[v]; }
+    int component(int v) const { return root_[v]; }
+    int componentSize(int root) const { return size_[root]; }
+    int numComponents() const { return numComponents_; }
+
+    // Was u entered before v in the forest's DFS order?
+    bool discoveredBefore(int u, int v) const { return label_[enter(u)] < label_[enter(v)]; }
+
+    // Root's tree in discovery order
+    std::vector<int> preorder(int root) const {
+        std::vector<int> order;
+        for (int node = enter(root); node != exit(root); node = next_[node]) {
+            if (!(node & 1)) order.push_back(node >> 1);
+        }
+        return order;
+    }
+
+    // Applies the updates in order, repairing the forest after each one
+    ForestUpdateStats apply(const std::vector<EdgeUpdate>& batch) {
+        ForestUpdateStats stats;
+        auto base = csrEdges(base_);
+        for (const EdgeUpdate& update : batch) {
+            bool isTreeEdge = parent_[update.to] == update.from;
+            if (!overlay_.apply(base, update)) {
+                stats.ignored++;
+            } else if (update.remove) {
+                stats.deleted++;
+                if (isTreeEdge) stats.moved += cut(update.to);
+            } else {
+                stats.inserted++;
+                if (label_[exit(update.from)] < label_[enter(update.to)]) {
+                    stats.moved += reattach(update.from, update.to);
+                }
+            }
+        }
+        return stats;
+    }
+
+private:
+    // Tour nodes: 2v enters v, 2v + 1 exits it, head_ closes the circle
+    static int enter(int v) { return 2 * v; }
+    static int exit(int v) { return 2 * v + 1; }
+
+    // Smallest label gap left after respacing a window of the tour
+    static const uint64_t MIN_GAP = 64;
+
+    // Next live out-neighbor of v at or after position i, or -1
+    int nextNeighbor(int v, int& i) const {
+        int degree = base_.degree(v);
+        while (i < degree) {
+            int u = base_[v][i++];
+            if (!overlay_.removed(v, u)) return u;
+        }
+        const std::vector<int>* extra = overlay_.addedOut(v);
+        if (extra && i - degree < (int)extra->size()) return (*extra)[i++ - degree];
+        return -1;
+    }
+
+    void build() {
+        int n = numVertices_ = base_.size();
+        parent_.assign(n, -1);
+        root_.assign(n, -1);
+        size_.assign(n, 0);
+        mark_.assign(n, 0);
+        epoch_ = 1;
+        head_ = 2 * n;
+        next_.assign(2 * n + 1, head_);
+        prev_.assign(2 * n + 1, head_);
+        label_.assign(2 * n + 1, 0);
+        numComponents_ = 0;
+
+        std::vector<int> tour;
+        tour.reserve(2 * n);
+        for (int root = 0; root < n; root++) {
+            if (mark_[root] == epoch_) continue;
+            size_t first = tour.size();
+            explore(root, -1, [](int) { return true; }, tour);
+            for (size_t i = first; i < tour.size(); i++) {
+                if (!(tour[i] & 1)) root_[tour[i] >> 1] = root;
+            }
+            size_[root] = (tour.size() - first) / 2;
+            numComponents_++;
+        }
+        int last = head_;
+        for (int node : tour) {
+            link(last, node);
+            last = node;
+        }
+        link(last, head_);
+        uint64_t step = UINT64_MAX / (tour.size() + 1);
+        for (size_t i = 0; i < tour.size(); i++) label_[tour[i]] = (i + 1) * step;
+    }
+
+    // DFS from start (child of parent) over unmarked vertices that accept()
+    // takes, recording their tour nodes and parents
+    template <typename Accept>
+    void explore(int start, int parent, Accept accept, std::vector<int>& tour) {
+        mark_[start] = epoch_;
+        parent_[start] = parent;
+        tour.push_back(enter(start));
+        frames_.clear();
+        frames_.push_back({start, 0});
+        while (!frames_.empty()) {
+            int v = frames_.back().vertex;
+            int u = nextNeighbor(v, frames_.back().next);
+            if (u < 0) {
+                tour.push_back(exit(v));
+                frames_.pop_back();
+                continue;
+            }
+            if (mark_[u] == epoch_ || !accept(u)) continue;
+            mark_[u] = epoch_;
+            parent_[u] = v;
+            tour.push_back(enter(u));
+            frames_.push_back({u, 0});
+        }
+    }
+
+    // Moves v, and everything reachable from it through vertices entered
+    // after a exited, under a as its last child. Returns how many moved.
+    long long reattach(int a, int v) {
+        uint64_t exited = label_[exit(a)];
+        std::vector<int> tour;
+        nextEpoch();
+        explore(v, a, [&](int u) { return label_[enter(u)] > exited; }, tour);
+
+        int root = root_[a];
+        for (int node : tour) {
+            unlink(node);
+            if (node & 1) continue;
+            int u = node >> 1;
+            size_[root_[u]]--;
+            if (root_[u] == u) numComponents_--;
+            root_[u] = root;
+        }
+        long long moved = tour.size() / 2;
+        size_[root] += moved;
+        splice(prev_[exit(a)], tour);
+        return moved;
+    }
+
+    // Tree edge parent(c) -> c is gone: c's subtree becomes the last tree,
+    // then every edge into it from outside that now points forward in
+    // time is repaired. Returns how many vertices changed place.
+    long long cut(int c) {
+        std::vector<int> tour;
+        for (int node = enter(c); node != next_[exit(c)]; node = next_[node]) tour.push_back(node);
+        for (int node : tour) unlink(node);
+        splice(prev_[head_], tour);
+
+        int oldRoot = root_[c];
+        parent_[c] = -1;
+        long long moved = tour.size() / 2;
+        size_[oldRoot] -= moved;
+        size_[c] = moved;
+        numComponents_++;
+        for (int node : tour) {
+            if (!(node & 1)) root_[node >> 1] = c;
+        }
+
+        // Edges into the subtree, earliest exit first
+        std::vector<std::pair<uint64_t, std::pair<int, int>>> broken;
+        for (int node : tour) {
+            if (node & 1) continue;
+            int s = node >> 1;
+            auto consider = [&](int x) {
+                if (root_[x] != c) broken.push_back({label_[exit(x)], {x, s}});
+            };
+            for (int x : reverse_[s]) {
+                if (!overlay_.removed(x, s)) consider(x);
+            }
+            if (const std::vector<int>* in = overlay_.addedIn(s)) {
+                for (int x : *in) consider(x);
+            }
+        }
+        std::sort(broken.begin(), broken.end());
+        for (const auto& edge : broken) {
+            int x = edge.second.first, s = edge.second.second;
+            if (label_[exit(x)] < label_[enter(s)]) reattach(x, s);
+        }
+        return moved;
+    }
+
+    void nextEpoch() {
+        if (++epoch_ == 0) {
+            std::fill(mark_.begin(), mark_.end(), 0);
+            epoch_ = 1;
+        }
+    }
+
+    void link(int a, int b) {
+        next_[a] = b;
+        prev_[b] = a;
+    }
+
+    void unlink(int node) { link(prev_[node], next_[node]); }
+
+    // Links nodes in after `after` and labels them between their neighbors
+    void splice(int after, const std::vector<int>& nodes) {
+        if (nodes.empty()) return;
+        int before = next_[after];
+        int last = after;
+        for (int node : nodes) {
+            link(last, node);
+            last = node;
+        }
+        link(last, before);
+        relabel(after, before, nodes.size());
+    }
+
+    // Spreads the count nodes strictly between lo and hi evenly over their
+    // label range, first widening the window until the gaps are at least
+    // MIN_GAP (or the window is the whole tour)
+    void relabel(int lo, int hi, long long count) {
+        while (true) {
+            uint64_t low = label_[lo];
+            uint64_t high = hi == head_ ? UINT64_MAX : label_[hi];
+            uint64_t gap = (high - low) / (count + 1);
+            if (gap >= MIN_GAP || (lo == head_ && hi == head_)) {
+                uint64_t label = low;
+                for (int node = next_[lo]; node != hi; node = next_[node]) label_[node] = label += gap;
+                return;
+            }
+            for (long long grow = count; grow > 0 && (lo != head_ || hi != head_); grow--) {
+                if (lo != head_) {
+                    lo = prev_[lo];
+                    count++;
+                }
+                if (hi != head_) {
+                    hi = next_[hi];
+                    count++;
+                }
+            }
+        }
+    }
+
+    const CSRGraph& base_;
+    CSRGraph reverse_;
+    EdgeOverlay& overlay_;
+    int numVertices_ = 0;
+
+    std::vector<int> parent_;
+    std::vector<int> root_;
+    std::vector<int> size_;         // tree size, at each root
+    int numComponents_ = 0;
+
+    std::vector<int> next_;
+    std::vector<int> prev_;
+    std::vector<uint64_t> label_;   // head_ keeps label 0
+    int head_ = 0;
+
+    std::vector<int> mark_;
+    int epoch_ = 0;
+    std::vector<DFSFrame> frames_;
+};
+
+#endif
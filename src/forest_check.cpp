@@ -0,0 +1,255 @@
+#include <iostream>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <cstdlib>
+#include "graph.h"
+#include "dynamic_forest.h"
+using namespace std;
+
+// Randomized check of DynamicDFSForest: applies random insert/delete
+// batches to small random graphs and compares the repaired forest with a
+// plain edge set after every batch.
+//
+//   forest_check [trials] [seed]
+//
+// After each batch the forest must be a valid DFS forest of the updated
+// graph (tree edges exist, each tree is one contiguous preorder, no edge
+// u -> v has v entered after u exited), vertex 0's tree must be exactly
+// the set reachable from vertex 0, and the stats, component sizes and
+// component count must match.
+
+struct Snapshot {
+    vector<int> parent;
+    vector<int> component;
+};
+
+static Snapshot snapshot(const DynamicDFSForest& forest) {
+    Snapshot s;
+    for (int v = 0; v < forest.numVertices(); v++) {
+        s.parent.push_back(forest.parent(v));
+        s.component.push_back(forest.component(v));
+    }
+    return s;
+}
+
+// Checks the forest against the reference adjacency; error says what broke
+static bool checkForest(const DynamicDFSForest& forest, const vector<set<int>>& adj, string& error) {
+    int n = adj.size();
+
+    // Whole forest in discovery order: the trees, roots ordered by entry time
+    vector<int> roots;
+    for (int v = 0; v < n; v++) {
+        if (forest.parent(v) < 0) roots.push_back(v);
+    }
+    sort(roots.begin(), roots.end(), [&](int a, int b) { return forest.discoveredBefore(a, b); });
+    if (roots.empty() || roots[0] != 0) {
+        error = "vertex 0 is not the first root";
+        return false;
+    }
+    if ((int)roots.size() != forest.numComponents()) {
+        error = "numComponents " + to_string(forest.numComponents()) + ", roots " + to_string(roots.size());
+        return false;
+    }
+
+    vector<int> order;
+    for (int root : roots) {
+        vector<int> tree = forest.preorder(root);
+        if (tree.empty() || tree[0] != root || (int)tree.size() != forest.componentSize(root)) {
+            error = "tree of " + to_string(root) + " has " + to_string(tree.size()) +
+                    " vertices, componentSize " + to_string(forest.componentSize(root));
+            return false;
+        }
+        for (int v : tree) {
+            if (forest.component(v) != root) {
+                error = "vertex " + to_string(v) + " in tree " + to_string(root) +
+                        " has component " + to_string(forest.component(v));
+                return false;
+            }
+            order.push_back(v);
+        }
+    }
+    vector<int> pos(n, -1);
+    for (int i = 0; i < (int)order.size(); i++) {
+        if (pos[order[i]] >= 0) {
+            error = "vertex " + to_string(order[i]) + " appears twice";
+            return false;
+        }
+        pos[order[i]] = i;
+    }
+    if ((int)order.size() != n) {
+        error = "forest covers " + to_string(order.size()) + " of " + to_string(n) + " vertices";
+        return false;
+    }
+
+    // Subtree sizes from the parent pointers; in a preorder, v's subtree is
+    // then [pos[v], pos[v] + size[v]) and its exit follows the last of it
+    vector<int> size(n, 1);
+    for (int i = n - 1; i >= 0; i--) {
+        int v = order[i];
+        int p = forest.parent(v);
+        if (p < 0) continue;
+        if (!adj[p].count(v)) {
+            error = "tree edge " + to_string(p) + " -> " + to_string(v) + " is not in the graph";
+            return false;
+        }
+        if (pos[p] >= pos[v]) {
+            error = "parent " + to_string(p) + " entered after child " + to_string(v);
+            return false;
+        }
+        size[p] += size[v];
+    }
+    vector<int> ancestors;
+    for (int v : order) {
+        while (!ancestors.empty() && pos[v] >= pos[ancestors.back()] + size[ancestors.back()]) ancestors.pop_back();
+        int expected = ancestors.empty() ? -1 : ancestors.back();
+        if (forest.parent(v) != expected) {
+            error = "vertex " + to_string(v) + " is not in its parent's preorder interval";
+            return false;
+        }
+        ancestors.push_back(v);
+    }
+    for (int u = 0; u < n; u++) {
+        for (int v : adj[u]) {
+            if (pos[v] >= pos[u] + size[u]) {
+                error = "edge " + to_string(u) + " -> " + to_string(v) + " enters " + to_string(v) +
+                        " after " + to_string(u) + " exited";
+                return false;
+            }
+        }
+    }
+
+    // Vertex 0's tree against a fresh traversal
+    vector<char> reached(n, 0);
+    vector<int> stack = {0};
+    reached[0] = 1;
+    int count = 1;
+    while (!stack.empty()) {
+        int v = stack.back();
+        stack.pop_back();
+        for (int u : adj[v]) {
+            if (reached[u]) continue;
+            reached[u] = 1;
+            count++;
+            stack.push_back(u);
+        }
+    }
+    if (forest.componentSize(0) != count) {
+        error = "reached " + to_string(forest.componentSize(0)) + " from vertex 0, expected " + to_string(count);
+        return false;
+    }
+    for (int v = 0; v < n; v++) {
+        if (reached[v] != (forest.component(v) == 0)) {
+            error = "vertex " + to_string(v) + " reachability from 0 disagrees with the forest";
+            return false;
+        }
+    }
+    return true;
+}
+
+// One trial: a random graph and a run of random batches. Returns false
+// with error set on the first mismatch.
+static bool runTrial(mt19937& rng, string& error) {
+    int n = 2 + rng() % 200;
+    int degree = rng() % 4;
+    vector<vector<int>> lists(n);
+    for (int v = 0; v < n; v++) {
+        int d = rng() % (2 * degree + 1);
+        for (int j = 0; j < d; j++) lists[v].push_back(rng() % n);   // duplicates and self-loops too
+    }
+    CSRGraph base = buildGraph(n, [&](int v, auto&& emit) {
+        for (int u : lists[v]) emit(u);
+    });
+    vector<set<int>> adj(n);
+    for (int v = 0; v < n; v++) adj[v].insert(lists[v].begin(), lists[v].end());
+
+    EdgeOverlay overlay(n);
+    DynamicDFSForest forest(base, overlay);
+    if (!checkForest(forest, adj, error)) {
+        error = "initial forest: " + error;
+        return false;
+    }
+
+    int numBatches = 1 + rng() % 30;
+    for (int b = 0; b < numBatches; b++) {
+        // Mostly valid changes, with tree-edge deletions and no-ops mixed in
+        vector<EdgeUpdate> batch;
+        ForestUpdateStats expected;
+        vector<set<int>> next = adj;
+        int batchSize = 1 + rng() % 8;
+        for (int i = 0; i < batchSize; i++) {
+            int u = rng() % n, v = rng() % n;
+            bool remove = rng() % 2;
+            int kind = rng() % 4;
+            if (remove && kind == 0 && forest.parent(v) >= 0) {
+                u = forest.parent(v);
+            } else if (remove && kind != 3 && !next[u].empty()) {
+                auto it = next[u].begin();
+                advance(it, rng() % next[u].size());
+                v = *it;
+            } else if (!remove && kind == 3 && !next[u].empty()) {
+                v = *next[u].begin();
+            }
+            batch.push_back({u, v, remove});
+            if (remove ? next[u].erase(v) : next[u].insert(v).second) {
+                (remove ? expected.deleted : expected.inserted)++;
+            } else {
+                expected.ignored++;
+            }
+        }
+
+        Snapshot before = snapshot(forest);
+        ForestUpdateStats stats = forest.apply(batch);
+        adj.swap(next);
+        string where = "n=" + to_string(n) + " batch " + to_string(b) + ": ";
+        if (stats.inserted != expected.inserted || stats.deleted != expected.deleted ||
+            stats.ignored != expected.ignored) {
+            error = where + "stats " + to_string(stats.inserted) + "/" + to_string(stats.deleted) + "/" +
+                    to_string(stats.ignored) + ", expected " + to_string(expected.inserted) + "/" +
+                    to_string(expected.deleted) + "/" + to_string(expected.ignored);
+            return false;
+        }
+        if (!checkForest(forest, adj, error)) {
+            error = where + error;
+            return false;
+        }
+        CSRGraph updated = buildGraph(n, overlay.edges(csrEdges(base)));
+        for (int v = 0; v < n; v++) {
+            set<int> out(updated[v].begin(), updated[v].end());
+            if (out != adj[v]) {
+                error = where + "overlay edges out of " + to_string(v) + " differ";
+                return false;
+            }
+        }
+
+        // Every vertex given a new parent or tree moved at least once
+        long long changed = 0;
+        for (int v = 0; v < n; v++) {
+            changed += forest.parent(v) != before.parent[v] || forest.component(v) != before.component[v];
+        }
+        long long applied = stats.inserted + stats.deleted;
+        if (stats.moved < changed || stats.moved > applied * n) {
+            error = where + "moved " + to_string(stats.moved) + ", but " + to_string(changed) +
+                    " vertices changed place";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int trials = argc > 1 ? atoi(argv[1]) : 500;
+    unsigned seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+    mt19937 rng(seed);
+    for (int t = 0; t < trials; t++) {
+        string error;
+        if (!runTrial(rng, error)) {
+            cerr << "forest_check: trial " << t << " (seed " << seed << "): " << error << endl;
+            return 1;
+        }
+    }
+    cout << "forest_check: " << trials << " trials ok" << endl;
+    return 0;
+}
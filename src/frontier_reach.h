@@ -0,0 +1,187 @@
+#ifndef FRONTIER_REACH_H
+#define FRONTIER_REACH_H
+
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <omp.h>
+#include "graph.h"
+#include "atomic_bitmap.h"
+
+// Reachability without DFS order: a level-synchronous traversal that finds
+// the same vertex set as a DFS from the same source, one frontier at a
+// time, so every level is a parallel loop instead of a chain of stack
+// pops. Frontiers are bitmaps. Each level runs either top-down (frontier
+// vertices claim their unvisited out-neighbors) or bottom-up (unvisited
+// vertices look for an in-neighbor in the frontier and stop at the first
+// one), whichever touches fewer edges (Beamer's direction-optimizing BFS):
+// bottom-up pays off for the few huge middle levels, top-down for the
+// thin ones at the start and end.
+
+// What a driver runs for a query: the DFS engines, which also produce a
+// preorder, or the frontier traversal, which only answers found and the
+// reached count
+enum class TraversalMode {
+    DFS,
+    Frontier
+};
+
+inline bool parseTraversalMode(const std::string& name, TraversalMode& mode) {
+    if (name == "dfs") {
+        mode = TraversalMode::DFS;
+    } else if (name == "frontier") {
+        mode = TraversalMode::Frontier;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline const char* traversalModeName(TraversalMode mode) {
+    return mode == TraversalMode::Frontier ? "frontier" : "dfs";
+}
+
+// Drivers take TRAVERSAL_MODE (dfs or frontier) from the environment;
+// returns false for an unknown name
+inline bool traversalModeFromEnv(TraversalMode& mode) {
+    mode = TraversalMode::DFS;
+    const char* name = std::getenv("TRAVERSAL_MODE");
+    return !name || !*name || parseTraversalMode(name, mode);
+}
+
+// Go bottom-up once the frontier's out-edges exceed the unexplored edges
+// over ALPHA, and back top-down once the frontier is shrinking and smaller
+// than the graph over BETA
+const int FRONTIER_ALPHA = 14;
+const int FRONTIER_BETA = 24;
+
+struct FrontierResult {
+    bool found = false;
+    long long visited = 0;      // vertices reached, all reachable ones unless found
+    int levels = 0;
+    int bottomUpLevels = 0;
+};
+
+// Direction choice, shared with the distributed version so both switch
+// on the same rule
+struct FrontierDirection {
+    bool bottomUp = false;
+    long long previousSize = 0;
+
+    void next(long long frontierSize, long long frontierEdges, long long unexploredEdges,
+              long long numVertices) {
+        if (!bottomUp && frontierEdges > unexploredEdges / FRONTIER_ALPHA) {
+            bottomUp = true;
+        } else if (bottomUp && frontierSize < previousSize &&
+                   frontierSize < numVertices / FRONTIER_BETA) {
+            bottomUp = false;
+        }
+        previousSize = frontierSize;
+    }
+};
+
+// Runs on a graph and its transpose (pass the graph twice if it is
+// symmetric); both must outlive the engine. The bitmaps are reused by
+// every run.
+class FrontierReach {
+public:
+    FrontierReach(const CSRGraph& adj, const CSRGraph& reverse, int numThreads)
+        : adj_(adj), reverse_(reverse), numThreads_(numThreads < 1 ? 1 : numThreads),
+          visited_(adj.size()), frontier_(adj.size()), next_(adj.size()) {}
+
+    int numThreads() const { return numThreads_; }
+
+    // Every vertex reachable from source, stopping after the level that
+    // reaches target (-1 for none). visited() holds the reached set.
+    FrontierResult run(int source, int target) {
+        FrontierResult result;
+        visited_.clear();
+        frontier_.clear();
+        int n = adj_.size();
+        if (source < 0 || source >= n) return result;
+
+        visited_.tryClaim(source);
+        frontier_.tryClaim(source);
+        result.visited = 1;
+        result.found = source == target;
+        long long frontierSize = 1;
+        long long frontierEdges = adj_.degree(source);
+        long long unexploredEdges = adj_.numEdges() - frontierEdges;
+        FrontierDirection direction;
+
+        while (frontierSize > 0 && !result.found) {
+            direction.next(frontierSize, frontierEdges, unexploredEdges, n);
+            next_.clear();
+            long long nextSize = 0, nextEdges = 0;
+            bool hit = false;
+            if (direction.bottomUp) {
+                bottomUpStep(target, nextSize, nextEdges, hit);
+                result.bottomUpLevels++;
+            } else {
+                topDownStep(target, nextSize, nextEdges, hit);
+            }
+            result.levels++;
+            result.visited += nextSize;
+            result.found = hit;
+            frontier_.swap(next_);
+            frontierSize = nextSize;
+            frontierEdges = nextEdges;
+            unexploredEdges -= nextEdges;
+        }
+        return result;
+    }
+
+    const AtomicBitmap& visited() const { return visited_; }
+
+private:
+    void addToNext(int u, int target, long long& size, long long& edges, bool& hit) {
+        next_.tryClaim(u);
+        size++;
+        edges += adj_.degree(u);
+        if (u == target) hit = true;
+    }
+
+    void topDownStep(int target, long long& nextSize, long long& nextEdges, bool& hit) {
+        long long numWords = frontier_.numWords();
+        #pragma omp parallel for schedule(dynamic, 16) num_threads(numThreads_) \
+            reduction(+:nextSize, nextEdges) reduction(||:hit)
+        for (long long w = 0; w < numWords; w++) {
+            for (uint64_t bits = frontier_.word(w); bits; bits &= bits - 1) {
+                int v = w * 64 + __builtin_ctzll(bits);
+                for (int u : adj_[v]) {
+                    if (visited_.tryClaim(u)) addToNext(u, target, nextSize, nextEdges, hit);
+                }
+            }
+        }
+    }
+
+    // Every thread owns whole words of the unvisited set, so its claims
+    // never race
+    void bottomUpStep(int target, long long& nextSize, long long& nextEdges, bool& hit) {
+        long long numWords = visited_.numWords();
+        int n = adj_.size();
+        #pragma omp parallel for schedule(dynamic, 16) num_threads(numThreads_) \
+            reduction(+:nextSize, nextEdges) reduction(||:hit)
+        for (long long w = 0; w < numWords; w++) {
+            for (uint64_t bits = ~visited_.word(w); bits; bits &= bits - 1) {
+                int v = w * 64 + __builtin_ctzll(bits);
+                if (v >= n) break;
+                for (int p : reverse_[v]) {
+                    if (!frontier_.test(p)) continue;
+                    visited_.tryClaim(v);
+                    addToNext(v, target, nextSize, nextEdges, hit);
+                    break;
+                }
+            }
+        }
+    }
+
+    const CSRGraph& adj_;
+    const CSRGraph& reverse_;
+    int numThreads_;
+    AtomicBitmap visited_;
+    AtomicBitmap frontier_;
+    AtomicBitmap next_;
+};
+
+#endif
@@ -2,11 +2,135 @@
 """
 Performance Profiling Visualization Script
 Generates graphs for DFS traversal performance analysis
+
+    python src/generate_graphs.py                      # profile.cpp snapshot below
+    python src/generate_graphs.py bench_1.json bench_2.json results.csv
+
+Given benchmark result files (JSON or CSV written by the benchmark driver,
+one per rank count), plots median times with p95 bars, speedup over the
+serial engine, throughput and MPI rank scaling instead.
 """
 
+import csv
+import json
+import sys
+from collections import defaultdict
+
 import matplotlib.pyplot as plt
 import numpy as np
 
+
+NUMERIC_FIELDS = ('vertices', 'edges', 'threads', 'ranks', 'stride', 'visited',
+                  'edges_traversed', 'warmup', 'runs')
+TIME_FIELDS = ('median_s', 'p95_s', 'mean_s', 'stddev_s', 'min_s', 'max_s', 'edges_per_s')
+
+
+def load_benchmark_records(paths):
+    """Records from every file, with numeric fields converted"""
+    records = []
+    for path in paths:
+        with open(path) as f:
+            if path.endswith('.csv'):
+                rows = list(csv.DictReader(f))
+            else:
+                rows = json.load(f)['records']
+        for row in rows:
+            for field in NUMERIC_FIELDS:
+                row[field] = int(row[field])
+            for field in TIME_FIELDS:
+                row[field] = float(row[field])
+            records.append(row)
+    return records
+
+
+def plot_benchmark_results(paths, output_file='docs/benchmark_graphs.png'):
+    records = load_benchmark_records(paths)
+    if not records:
+        print("No benchmark records found")
+        return
+
+    graphs = sorted({(r['graph'], r['vertices']) for r in records})
+    fig, axes = plt.subplots(len(graphs), 4, figsize=(22, 5 * len(graphs)), squeeze=False)
+
+    for row, (graph, vertices) in enumerate(graphs):
+        # NUMA placement sweeps (--placement) are left out of these plots
+        rows = [r for r in records if r['graph'] == graph and r['vertices'] == vertices and r['stride'] == 1
+                and r.get('placement', 'default') == 'default']
+        serial = [r for r in rows if r['engine'] == 'serial']
+        serial_s = serial[0]['median_s'] if serial else None
+        label = f'{graph} ({vertices} vertices)'
+
+        # Median time vs threads, p95 as the upper error bar
+        ax = axes[row][0]
+        for engine in ('openmp', 'hybrid'):
+            by_threads = sorted((r for r in rows if r['engine'] == engine and r['ranks'] == 1),
+                                key=lambda r: r['threads'])
+            if not by_threads:
+                continue
+            t = [r['threads'] for r in by_threads]
+            med = [r['median_s'] * 1000 for r in by_threads]
+            upper = [(r['p95_s'] - r['median_s']) * 1000 for r in by_threads]
+            ax.errorbar(t, med, yerr=[[0] * len(t), upper], fmt='o-', capsize=4, label=engine)
+        if serial_s:
+            ax.axhline(y=serial_s * 1000, color='green', linestyle='--', label='serial')
+        ax.set_title(f'Median time: {label}', fontweight='bold')
+        ax.set_xlabel('Threads')
+        ax.set_ylabel('Time (ms, bar to p95)')
+        ax.legend()
+        ax.grid(True, alpha=0.3)
+
+        # Speedup over the serial engine
+        ax = axes[row][1]
+        if serial_s:
+            for engine in ('openmp', 'hybrid'):
+                by_threads = sorted((r for r in rows if r['engine'] == engine and r['ranks'] == 1),
+                                    key=lambda r: r['threads'])
+                if by_threads:
+                    ax.plot([r['threads'] for r in by_threads],
+                            [serial_s / r['median_s'] for r in by_threads], 'o-', label=engine)
+            ax.axhline(y=1.0, color='red', linestyle=':', label='serial')
+        ax.set_title('Speedup over serial', fontweight='bold')
+        ax.set_xlabel('Threads')
+        ax.set_ylabel('T_serial / T')
+        ax.legend()
+        ax.grid(True, alpha=0.3)
+
+        # Best throughput per engine
+        ax = axes[row][2]
+        best = defaultdict(float)
+        for r in rows:
+            best[r['engine']] = max(best[r['engine']], r['edges_per_s'])
+        engines = sorted(best)
+        ax.bar(engines, [best[e] / 1e6 for e in engines], color='purple', alpha=0.7)
+        ax.set_title('Best throughput', fontweight='bold')
+        ax.set_ylabel('Million edges / s')
+        ax.grid(True, alpha=0.3, axis='y')
+
+        # MPI / hybrid time vs rank count (one benchmark file per count)
+        ax = axes[row][3]
+        for engine in ('mpi', 'hybrid'):
+            per_ranks = defaultdict(list)
+            for r in rows:
+                if r['engine'] == engine:
+                    per_ranks[r['ranks']].append(r['median_s'])
+            if per_ranks:
+                ranks = sorted(per_ranks)
+                ax.plot(ranks, [min(per_ranks[p]) * 1000 for p in ranks], 's-', label=engine)
+        ax.set_title('Distributed engines vs ranks', fontweight='bold')
+        ax.set_xlabel('Ranks')
+        ax.set_ylabel('Best median time (ms)')
+        ax.legend()
+        ax.grid(True, alpha=0.3)
+
+    plt.tight_layout()
+    plt.savefig(output_file, dpi=150, bbox_inches='tight')
+    print(f"Benchmark graphs saved to {output_file}")
+
+
+if len(sys.argv) > 1:
+    plot_benchmark_results(sys.argv[1:])
+    sys.exit(0)
+
 # Performance data from profiling results
 threads = [2, 4, 8, 16]
 T_P = [0.003119, 0.004229, 0.008202, 0.009997]  # seconds
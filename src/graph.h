@@ -0,0 +1,230 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+// Contiguous view over the neighbors of one vertex
+struct NeighborRange {
+    const int* first;
+    const int* last;
+
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    size_t size() const { return last - first; }
+    int operator[](size_t idx) const { return first[idx]; }
+};
+
+// One CSR array: either an owned vector or a read-only view into memory
+// owned elsewhere (a mapped graph file, see graph_io.h). keepAlive holds
+// that memory for as long as any copy of the view exists. Writing through
+// a view is not allowed.
+template <typename T>
+class CSRArray {
+public:
+    void assign(size_t n, const T& value) {
+        release();
+        owned_.assign(n, value);
+    }
+    void resize(size_t n) {
+        release();
+        owned_.resize(n);
+    }
+    void setView(const T* data, size_t n, std::shared_ptr<const void> keepAlive) {
+        owned_.clear();
+        owned_.shrink_to_fit();
+        view_ = data;
+        viewSize_ = n;
+        keepAlive_ = std::move(keepAlive);
+    }
+
+    bool isView() const { return view_ != nullptr; }
+    const T* data() const { return view_ ? view_ : owned_.data(); }
+    T* data() { return view_ ? const_cast<T*>(view_) : owned_.data(); }
+    size_t size() const { return view_ ? viewSize_ : owned_.size(); }
+    bool empty() const { return size() == 0; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+
+    const T& operator[](size_t idx) const { return data()[idx]; }
+    T& operator[](size_t idx) { return view_ ? const_cast<T&>(view_[idx]) : owned_[idx]; }
+
+private:
+    void release() {
+        view_ = nullptr;
+        viewSize_ = 0;
+        keepAlive_.reset();
+    }
+
+    std::vector<T> owned_;
+    const T* view_ = nullptr;
+    size_t viewSize_ = 0;
+    std::shared_ptr<const void> keepAlive_;
+};
+
+// Compressed sparse row graph: the neighbors of vertex v are stored in
+// neighbors[offsets[v]] .. neighbors[offsets[v + 1] - 1], so the whole
+// adjacency lives in two allocations instead of one per vertex.
+struct CSRGraph {
+    int numVertices = 0;
+    CSRArray<int64_t> offsets;      // numVertices + 1 entries
+    CSRArray<int> neighbors;        // offsets[numVertices] entries
+
+    int size() const { return numVertices; }
+    int64_t numEdges() const { return offsets.empty() ? 0 : offsets[numVertices]; }
+    int degree(int v) const { return (int)(offsets[v + 1] - offsets[v]); }
+
+    NeighborRange operator[](int v) const {
+        const int* base = neighbors.data();
+        return {base + offsets[v], base + offsets[v + 1]};
+    }
+};
+
+// offsets[v + 1] holds the degree of v on entry and its end offset on
+// exit. Blocks of vertices are summed in parallel, then each block adds
+// the total of the blocks before it.
+inline void prefixSumOffsets(CSRArray<int64_t>& offsets, int numVertices) {
+    int64_t* sums = offsets.data();
+    const int BLOCK = 1 << 16;
+    int numBlocks = (numVertices + BLOCK - 1) / BLOCK;
+    std::vector<int64_t> blockStart(numBlocks + 1, 0);
+
+    #pragma omp parallel for
+    for (int b = 0; b < numBlocks; b++) {
+        int end = std::min(numVertices, (b + 1) * BLOCK);
+        int64_t sum = 0;
+        for (int v = b * BLOCK; v < end; v++) {
+            sum += sums[v + 1];
+            sums[v + 1] = sum;
+        }
+        blockStart[b + 1] = sum;
+    }
+    for (int b = 0; b < numBlocks; b++) blockStart[b + 1] += blockStart[b];
+
+    #pragma omp parallel for
+    for (int b = 1; b < numBlocks; b++) {
+        int end = std::min(numVertices, (b + 1) * BLOCK);
+        for (int v = b * BLOCK; v < end; v++) sums[v + 1] += blockStart[b];
+    }
+}
+
+// Build a CSR graph from a generator called as gen(v, emit), where emit(u)
+// appends the edge v -> u. Degrees are counted in parallel, prefix-summed,
+// and every vertex then fills its own slice of neighbors, so threads never
+// write to the same place. The generator is called twice per vertex and
+// from several threads at once: it must be deterministic and must not
+// modify shared state. Edge order per vertex is preserved.
+template <typename EdgeGenerator>
+CSRGraph buildGraph(int numVertices, EdgeGenerator gen) {
+    CSRGraph graph;
+    graph.numVertices = numVertices;
+    graph.offsets.assign(numVertices + 1, 0);
+    int64_t* offsets = graph.offsets.data();
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int v = 0; v < numVertices; v++) {
+        int64_t degree = 0;
+        gen(v, [&](int) { degree++; });
+        offsets[v + 1] = degree;
+    }
+    prefixSumOffsets(graph.offsets, numVertices);
+
+    graph.neighbors.resize(offsets[numVertices]);
+    int* neighbors = graph.neighbors.data();
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int v = 0; v < numVertices; v++) {
+        int64_t pos = offsets[v];
+        gen(v, [&](int u) { neighbors[pos++] = u; });
+    }
+    return graph;
+}
+
+// Sort every neighbor list in place. Used after filling lists with atomic
+// cursors, whose order depends on thread timing.
+inline void sortNeighborLists(CSRGraph& graph) {
+    const int64_t* offsets = graph.offsets.data();
+    int* neighbors = graph.neighbors.data();
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int v = 0; v < graph.size(); v++) {
+        std::sort(neighbors + offsets[v], neighbors + offsets[v + 1]);
+    }
+}
+
+// Graph with every edge reversed (in-neighbors become neighbors), built in
+// parallel. In-neighbors are listed in ascending order.
+inline CSRGraph transposeGraph(const CSRGraph& adj) {
+    int n = adj.size();
+    CSRGraph reverse;
+    reverse.numVertices = n;
+    reverse.offsets.assign(n + 1, 0);
+    int64_t* offsets = reverse.offsets.data();
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int v = 0; v < n; v++) {
+        for (int u : adj[v]) {
+            #pragma omp atomic
+            offsets[u + 1]++;
+        }
+    }
+    prefixSumOffsets(reverse.offsets, n);
+
+    reverse.neighbors.resize(adj.numEdges());
+    int* neighbors = reverse.neighbors.data();
+    std::vector<int64_t> fill(reverse.offsets.begin(), reverse.offsets.end() - 1);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int v = 0; v < n; v++) {
+        for (int u : adj[v]) {
+            int64_t pos;
+            #pragma omp atomic capture
+            pos = fill[u]++;
+            neighbors[pos] = v;
+        }
+    }
+    sortNeighborLists(reverse);
+    return reverse;
+}
+
+// Edge generator for the test graph used by the serial, OpenMP and
+// profiling drivers (see buildGraph for the generator contract)
+inline auto testGraphEdges(int numVertices) {
+    return [numVertices](int i, auto&& emit) {
+        int connections = 2 + (i % 3);
+        for (int j = 1; j <= connections; j++) {
+            int neighbor = (i * 7 + j * 13) % numVertices;
+            if (neighbor != i) {
+                emit(neighbor);
+            }
+        }
+    };
+}
+
+// Edge generator for the circulant graph (i -> i + 7, i + 14, i + 21)
+// used by the MPI drivers
+inline auto circulantEdges(int numVertices) {
+    return [numVertices](int i, auto&& emit) {
+        for (int j = 1; j <= 3; j++) {
+            emit((i + j * 7) % numVertices);
+        }
+    };
+}
+
+// Edge generator that replays an existing graph, e.g. a mapped file, so it
+// can be fed to buildGraph / buildDistributedGraph like the formulas above
+inline auto csrEdges(const CSRGraph& graph) {
+    return [&graph](int v, auto&& emit) {
+        for (int u : graph[v]) emit(u);
+    };
+}
+
+inline CSRGraph createTestGraph(int numVertices) {
+    return buildGraph(numVertices, testGraphEdges(numVertices));
+}
+
+inline CSRGraph createCirculantGraph(int numVertices) {
+    return buildGraph(numVertices, circulantEdges(numVertices));
+}
+
+#endif
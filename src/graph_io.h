@@ -0,0 +1,314 @@
+#ifndef GRAPH_IO_H
+#define GRAPH_IO_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <omp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "graph.h"
+
+// Binary CSR graph file, laid out so it can be mapped and used in place:
+//
+//   GraphFileHeader                 32 bytes
+//   int64_t offsets[numVertices + 1]
+//   int32_t neighbors[numEdges]
+//
+// All fields are little-endian (native on the machines we run on). The
+// offsets start at byte 32 and are 8-byte aligned, so neither array needs
+// to be copied after mapping.
+struct GraphFileHeader {
+    char magic[8];          // GRAPH_FILE_MAGIC
+    uint32_t version;
+    uint32_t flags;         // reserved, 0
+    int64_t numVertices;
+    int64_t numEdges;
+};
+
+static const char GRAPH_FILE_MAGIC[8] = {'P', 'D', 'F', 'S', 'C', 'S', 'R', '\0'};
+static const uint32_t GRAPH_FILE_VERSION = 1;
+
+// Every engine indexes with offsets and neighbor ids unchecked: check
+// that the offsets start at 0 and never decrease and that every id lies
+// in [0, n). One parallel pass over both arrays.
+inline bool validateGraph(const CSRGraph& graph, std::string& error) {
+    int64_t n = graph.size();
+    if ((int64_t)graph.offsets.size() != n + 1 || graph.offsets[0] != 0 ||
+        (int64_t)graph.neighbors.size() != graph.numEdges()) {
+        error = "graph arrays do not match its vertex and edge counts";
+        return false;
+    }
+    const int64_t* offsets = graph.offsets.data();
+    const int* neighbors = graph.neighbors.data();
+    int64_t m = graph.numEdges();
+    int64_t badOffsets = 0, badNeighbors = 0;
+    #pragma omp parallel for reduction(+:badOffsets)
+    for (int64_t v = 0; v < n; v++) {
+        if (offsets[v + 1] < offsets[v]) badOffsets++;
+    }
+    if (badOffsets) {
+        error = "graph has decreasing offsets";
+        return false;
+    }
+    #pragma omp parallel for reduction(+:badNeighbors)
+    for (int64_t e = 0; e < m; e++) {
+        if (neighbors[e] < 0 || neighbors[e] >= n) badNeighbors++;
+    }
+    if (badNeighbors) {
+        error = "graph has " + std::to_string(badNeighbors) + " neighbor ids outside [0, " +
+                std::to_string(n) + ")";
+        return false;
+    }
+    return true;
+}
+
+inline bool writeGraphFile(const std::string& path, const CSRGraph& graph, std::string& error) {
+    if (!validateGraph(graph, error)) {
+        error = "not writing " + path + ": " + error;
+        return false;
+    }
+    FILE* out = std::fopen(path.c_str(), "wb");
+    if (!out) {
+        error = "cannot open " + path + " for writing";
+        return false;
+    }
+    GraphFileHeader header;
+    std::memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic));
+    header.version = GRAPH_FILE_VERSION;
+    header.flags = 0;
+    header.numVertices = graph.size();
+    header.numEdges = graph.numEdges();
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+              std::fwrite(graph.offsets.data(), sizeof(int64_t), graph.offsets.size(), out) == graph.offsets.size() &&
+              std::fwrite(graph.neighbors.data(), sizeof(int), graph.neighbors.size(), out) == graph.neighbors.size();
+    ok = (std::fclose(out) == 0) && ok;
+    if (!ok) error = "write to " + path + " failed";
+    return ok;
+}
+
+// Map a graph file read-only. The arrays of graph point straight into the
+// mapping (MAP_SHARED, so ranks on one node share the page cache copy)
+// and pages are faulted in on first touch; the mapping is released with
+// the last copy of graph. Only the header and the end offsets are checked
+// here, so loading stays O(1): the full scan is validateGraph(), run by
+// writeGraphFile() and by convert_graph --verify.
+inline bool mapGraphFile(const std::string& path, CSRGraph& graph, std::string& error) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(GraphFileHeader)) {
+        close(fd);
+        error = path + " is not a graph file (too short)";
+        return false;
+    }
+    size_t length = st.st_size;
+    void* base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    std::shared_ptr<const void> mapping(base, [length](const void* p) {
+        munmap(const_cast<void*>(p), length);
+    });
+
+    const GraphFileHeader* header = static_cast<const GraphFileHeader*>(base);
+    if (std::memcmp(header->magic, GRAPH_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != GRAPH_FILE_VERSION) {
+        error = path + " is not a version " + std::to_string(GRAPH_FILE_VERSION) + " graph file";
+        return false;
+    }
+    int64_t n = header->numVertices;
+    int64_t m = header->numEdges;
+    if (n < 0 || n >= INT_MAX || m < 0 ||
+        length != sizeof(GraphFileHeader) + (n + 1) * sizeof(int64_t) + m * sizeof(int)) {
+        error = path + " has a corrupt header";
+        return false;
+    }
+
+    const char* bytes = static_cast<const char*>(base);
+    const int64_t* offsets = reinterpret_cast<const int64_t*>(bytes + sizeof(GraphFileHeader));
+    const int* neighbors = reinterpret_cast<const int*>(offsets + n + 1);
+    if (offsets[0] != 0 || offsets[n] != m) {
+        error = path + " has corrupt offsets";
+        return false;
+    }
+    graph.numVertices = (int)n;
+    graph.offsets.setView(offsets, n + 1, mapping);
+    graph.neighbors.setView(neighbors, m, mapping);
+    return true;
+}
+
+// Parse the edge lines in [p, end), which starts at a line boundary, into
+// sources / targets. Anything after the two ids (e.g. a weight) is ignored.
+// Returns nullptr on success, otherwise the start of the first bad line.
+inline const char* parseEdgeLines(const char* p, const char* end, std::vector<int>& sources,
+                                  std::vector<int>& targets, int& maxVertex) {
+    while (p < end) {
+        const char* line = p;
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+        p = eol < end ? eol + 1 : end;
+
+        const char* c = line;
+        while (c < eol && (*c == ' ' || *c == '\t')) c++;
+        if (c == eol || *c == '\r' || *c == '#' || *c == '%') continue;
+
+        int64_t ids[2];
+        for (int k = 0; k < 2; k++) {
+            while (c < eol && (*c == ' ' || *c == '\t')) c++;
+            if (c == eol || *c < '0' || *c > '9') return line;
+            int64_t id = 0;
+            while (c < eol && *c >= '0' && *c <= '9') {
+                id = id * 10 + (*c++ - '0');
+                if (id >= INT_MAX) return line;
+            }
+            ids[k] = id;
+        }
+        sources.push_back((int)ids[0]);
+        targets.push_back((int)ids[1]);
+        if (ids[0] > maxVertex) maxVertex = (int)ids[0];
+        if (ids[1] > maxVertex) maxVertex = (int)ids[1];
+    }
+    return nullptr;
+}
+
+// Read a whitespace separated edge list ("u v" per line). Lines starting
+// with '#' or '%' are comments, which covers SNAP and most other dumps.
+// Vertex ids must be non-negative; the graph gets max id + 1 vertices.
+// With undirected, every edge is also added in reverse.
+//
+// The file is mapped and cut into one chunk per thread at line boundaries;
+// each thread parses its chunk into its own edge arrays. Degrees are then
+// counted with atomic increments, prefix-summed, and the edges scattered
+// through atomic cursors. Neighbor lists come out sorted, so the result
+// does not depend on the thread count (SNAP files are usually sorted
+// already, in which case this is also the file order).
+inline bool readEdgeList(const std::string& path, CSRGraph& graph, std::string& error,
+                         bool undirected = false) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        error = "cannot stat " + path;
+        return false;
+    }
+    size_t length = st.st_size;
+    const char* text = nullptr;
+    if (length > 0) {
+        void* base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            close(fd);
+            error = "cannot map " + path;
+            return false;
+        }
+        madvise(base, length, MADV_SEQUENTIAL);
+        text = static_cast<const char*>(base);
+    }
+    close(fd);
+
+    int numThreads = omp_get_max_threads();
+    std::vector<std::vector<int>> sources(numThreads);
+    std::vector<std::vector<int>> targets(numThreads);
+    std::vector<int> maxVertex(numThreads, -1);
+    std::vector<const char*> badLine(numThreads, nullptr);
+    int numChunks = numThreads;
+
+    // Chunk t starts after the first newline at or past t * length / numChunks
+    auto chunkStart = [&](int t) -> const char* {
+        if (t == 0) return text;
+        if (t >= numChunks) return text + length;
+        const char* p = text + (size_t)((double)length * t / numChunks);
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', text + length - p));
+        return eol ? eol + 1 : text + length;
+    };
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+        #pragma omp single
+        {
+            numChunks = omp_get_num_threads();
+        }
+        int tid = omp_get_thread_num();
+        const char* begin = chunkStart(tid);
+        const char* end = chunkStart(tid + 1);
+        if (begin < end) {
+            badLine[tid] = parseEdgeLines(begin, end, sources[tid], targets[tid], maxVertex[tid]);
+        }
+    }
+
+    for (int t = 0; t < numThreads && error.empty(); t++) {
+        if (badLine[t]) {
+            long long lineNumber = 1 + std::count(text, badLine[t], '\n');
+            error = path + ":" + std::to_string(lineNumber) + ": expected two vertex ids";
+        }
+    }
+    if (text) munmap(const_cast<char*>(text), length);
+    if (!error.empty()) return false;
+
+    int n = *std::max_element(maxVertex.begin(), maxVertex.end()) + 1;
+    graph.numVertices = n;
+    graph.offsets.assign(n + 1, 0);
+    int64_t* offsets = graph.offsets.data();
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int t = 0; t < numThreads; t++) {
+        for (size_t e = 0; e < sources[t].size(); e++) {
+            #pragma omp atomic
+            offsets[sources[t][e] + 1]++;
+            if (undirected) {
+                #pragma omp atomic
+                offsets[targets[t][e] + 1]++;
+            }
+        }
+    }
+    prefixSumOffsets(graph.offsets, n);
+
+    graph.neighbors.resize(offsets[n]);
+    int* neighbors = graph.neighbors.data();
+    std::vector<int64_t> fill(graph.offsets.begin(), graph.offsets.end() - 1);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int t = 0; t < numThreads; t++) {
+        for (size_t e = 0; e < sources[t].size(); e++) {
+            int u = sources[t][e];
+            int v = targets[t][e];
+            int64_t pos;
+            #pragma omp atomic capture
+            pos = fill[u]++;
+            neighbors[pos] = v;
+            if (undirected) {
+                #pragma omp atomic capture
+                pos = fill[v]++;
+                neighbors[pos] = u;
+            }
+        }
+    }
+    sortNeighborLists(graph);
+    return true;
+}
+
+// Drivers map the file named by GRAPH_FILE, when set, instead of building
+// their generated test graph
+inline const char* graphFileFromEnv() {
+    const char* path = std::getenv("GRAPH_FILE");
+    return (path && *path) ? path : nullptr;
+}
+
+#endif
@@ -5,6 +5,7 @@ import time
 import datetime
 import threading
 import logging
+import queue
 
 import grpc
 from concurrent.futures import ThreadPoolExecutor
@@ -26,8 +27,111 @@ except Exception:
     import dfs_pb2_grpc
 
 
+class DFSDaemon:
+    """Keeps one dfs_daemon process (see src/dfs_daemon.cpp) running and
+    talks to it over its stdin/stdout line protocol. The graph stays
+    resident in the daemon, so a request costs only the traversal. Requests
+    are serialized; a daemon that dies or stops answering is restarted on
+    the next request."""
+
+    def __init__(self, cmd, timeout):
+        self.cmd = cmd
+        self.timeout = timeout
+        self.lock = threading.Lock()
+        self.proc = None
+        self.lines = None
+
+    def _start(self):
+        self.proc = subprocess.Popen(self.cmd, stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                     universal_newlines=True, bufsize=1)
+        self.lines = queue.Queue()
+        # A reader thread lets _readline time out on every platform
+        threading.Thread(target=self._pump, args=(self.proc, self.lines), daemon=True).start()
+        ready = self._readline()
+        if not ready.startswith('ready'):
+            raise RuntimeError('daemon failed to start: ' + ready)
+        logging.info('daemon started pid=%d %s', self.proc.pid, ready)
+
+    @staticmethod
+    def _pump(proc, lines):
+        for line in proc.stdout:
+            lines.put(line.strip())
+        lines.put(None)
+
+    def _readline(self):
+        try:
+            line = self.lines.get(timeout=self.timeout)
+        except queue.Empty:
+            self.stop()
+            raise RuntimeError('daemon timed out')
+        if line is None:
+            self.stop()
+            raise RuntimeError('daemon exited')
+        return line
+
+    def stop(self):
+        if self.proc is not None:
+            if self.proc.poll() is None:
+                self.proc.kill()
+            self.proc.wait()
+        self.proc = None
+
+    def request(self, line):
+        with self.lock:
+            self._send(line)
+            return self._readline()
+
+    def request_stream(self, line):
+        """Yield reply lines up to and including the final ok/error line.
+        The daemon stays locked to this request while the caller iterates.
+        A caller that stops early (cancelled client, parse error) should
+        close() the generator; the rest of the reply is then read and
+        dropped so the next request does not get its lines."""
+        with self.lock:
+            self._send(line)
+            done = False
+            try:
+                while not done:
+                    reply = self._readline()
+                    done = reply.startswith('ok') or reply.startswith('error')
+                    yield reply
+            finally:
+                # _readline stops the daemon on timeout or exit, and a
+                # restarted daemon starts with an empty queue
+                while not done and self.proc is not None:
+                    try:
+                        reply = self._readline()
+                    except RuntimeError:
+                        break
+                    done = reply.startswith('ok') or reply.startswith('error')
+
+    def _send(self, line):
+        if self.proc is None or self.proc.poll() is not None:
+            self._start()
+        self.proc.stdin.write(line + '\n')
+        self.proc.stdin.flush()
+
+
+def parse_daemon_reply(reply):
+    """'ok found=1 visited=6001 ...' -> {'found': '1', 'visited': '6001', ...}"""
+    parts = reply.split()
+    if not parts or parts[0] != 'ok':
+        raise RuntimeError(reply)
+    return dict(p.split('=', 1) for p in parts[1:] if '=' in p)
+
+
+def wants_frontier(request):
+    """True for requests that only need found / visited_count and asked for the frontier engine"""
+    return getattr(request, 'mode', 0) == getattr(dfs_pb2, 'TRAVERSAL_FRONTIER', 1)
+
+
+def wants_forest(request):
+    """True for requests to be answered from the daemon's maintained DFS forest"""
+    return getattr(request, 'mode', 0) == getattr(dfs_pb2, 'TRAVERSAL_FOREST', 2)
+
+
 class DFSServiceServicer(dfs_pb2_grpc.DFSServiceServicer):
-    def __init__(self, exec_cmd, use_mpi=True, mpi_procs=4, logfile=None, timeout=120):
+    def __init__(self, exec_cmd, use_mpi=True, mpi_procs=4, logfile=None, timeout=120, daemon=False):
         self.exec_cmd = exec_cmd
         self.use_mpi = use_mpi
         self.mpi_procs = mpi_procs
@@ -35,8 +139,181 @@ class DFSServiceServicer(dfs_pb2_grpc.DFSServiceServicer):
         self.logfile = logfile or 'server.log'
         logging.basicConfig(filename=self.logfile, level=logging.INFO,
                             format='%(asctime)s %(message)s')
+        self.daemon = None
+        if daemon:
+            cmd = [exec_cmd]
+            if use_mpi:
+                cmd = ["mpirun", "-np", str(mpi_procs), exec_cmd]
+            self.daemon = DFSDaemon(cmd, timeout)
 
     def RunDFS(self, request, context):
+        if self.daemon is not None:
+            return self._run_in_daemon(request)
+        return self._run_subprocess(request)
+
+    def _run_in_daemon(self, request):
+        req_ts = datetime.datetime.utcnow().isoformat() + 'Z'
+        start = time.time()
+
+        reach = getattr(request, 'reachability_only', False)
+        line = 'reach' if reach else 'run'
+        if request.target:
+            line += ' target=%d' % request.target
+        if request.num_vertices:
+            line += ' vertices=%d' % request.num_vertices
+        if not reach and wants_frontier(request):
+            line += ' mode=frontier'
+        elif not reach and wants_forest(request):
+            line += ' mode=forest'
+
+        found = False
+        visited_count = 0
+        runtime_ms = 0.0
+        stdout = ''
+        stderr = ''
+        rc = 0
+        try:
+            stdout = self.daemon.request(line)
+            fields = parse_daemon_reply(stdout)
+            found = fields.get('reachable' if reach else 'found') == '1'
+            visited_count = int(fields.get('visited', 0))
+            runtime_ms = float(fields.get('runtime_ms', 0.0))
+        except Exception as e:
+            stderr = str(e)
+            rc = -1
+
+        latency_ms = (time.time() - start) * 1000.0
+        logging.info('request_ts=%s latency_ms=%.2f exit_code=%d found=%s visited=%d', req_ts, latency_ms, rc, found, visited_count)
+
+        return dfs_pb2.RunResponse(found=found, visited_count=visited_count, runtime_ms=runtime_ms, stdout=stdout, stderr=stderr)
+
+    def StreamDFS(self, request, context):
+        req_ts = datetime.datetime.utcnow().isoformat() + 'Z'
+        start = time.time()
+        if self.daemon is None:
+            # No resident traversal to observe: one summary event at the end
+            yield dfs_pb2.TraversalEvent(summary=self._run_subprocess(request))
+            return
+
+        line = 'stream'
+        if request.target:
+            line += ' target=%d' % request.target
+        if request.num_vertices:
+            line += ' vertices=%d' % request.num_vertices
+
+        summary = dfs_pb2.RunResponse()
+        stream = self.daemon.request_stream(line)
+        try:
+            for reply in stream:
+                kind, _, rest = reply.partition(' ')
+                if kind == 'chunk':
+                    vertices = [int(v) for v in rest.split(',')] if rest else []
+                    yield dfs_pb2.TraversalEvent(chunk=dfs_pb2.PreorderChunk(vertices=vertices))
+                    continue
+                if kind == 'error':
+                    summary = dfs_pb2.RunResponse(stderr=reply)
+                    break
+                fields = dict(p.split('=', 1) for p in rest.split() if '=' in p)
+                if kind == 'progress':
+                    yield dfs_pb2.TraversalEvent(progress=dfs_pb2.Progress(
+                        visited_count=int(fields['visited']), elapsed_ms=float(fields['elapsed_ms']),
+                        round=int(fields['round'])))
+                elif kind == 'found':
+                    yield dfs_pb2.TraversalEvent(found=dfs_pb2.FoundTarget(
+                        vertex=int(fields['vertex']), elapsed_ms=float(fields['elapsed_ms']),
+                        round=int(fields['round'])))
+                elif kind == 'ok':
+                    summary = dfs_pb2.RunResponse(found=fields.get('found') == '1',
+                                                  visited_count=int(fields.get('visited', 0)),
+                                                  runtime_ms=float(fields.get('runtime_ms', 0.0)),
+                                                  stdout=reply)
+        except Exception as e:
+            summary = dfs_pb2.RunResponse(stderr=str(e))
+        finally:
+            # Also runs when the client cancels: drain the daemon's reply
+            # and release its lock now rather than when the stream is collected
+            stream.close()
+
+        latency_ms = (time.time() - start) * 1000.0
+        logging.info('request_ts=%s latency_ms=%.2f stream found=%s visited=%d', req_ts, latency_ms, summary.found, summary.visited_count)
+        yield dfs_pb2.TraversalEvent(summary=summary)
+
+    def RunBatch(self, request, context):
+        req_ts = datetime.datetime.utcnow().isoformat() + 'Z'
+        start = time.time()
+        targets = list(request.targets)
+        sources = list(request.sources)
+
+        found = []
+        reached = []
+        runtime_ms = 0.0
+        stderr = ''
+        if self.daemon is not None:
+            line = 'batch targets=' + ','.join(str(t) for t in targets)
+            if sources:
+                line += ' sources=' + ','.join(str(s) for s in sources)
+            if request.num_vertices:
+                line += ' vertices=%d' % request.num_vertices
+            try:
+                fields = parse_daemon_reply(self.daemon.request(line))
+                found = [f == '1' for f in fields['found'].split(',')]
+                reached = [int(c) for c in fields['reached'].split(',')]
+                runtime_ms = float(fields.get('runtime_ms', 0.0))
+            except Exception as e:
+                found, reached, stderr = [], [], str(e)
+        elif any(sources):
+            stderr = 'batch sources other than 0 need --daemon'
+        else:
+            # Without a daemon, fall back to one launch per target. Those
+            # stop at their target, so the reachable count (the same for
+            # every query from vertex 0) takes one more full launch.
+            for target in targets:
+                resp = self._run_subprocess(dfs_pb2.RunRequest(target=target, num_vertices=request.num_vertices,
+                                                               use_mpi=True))
+                found.append(resp.found)
+                runtime_ms += resp.runtime_ms
+                if resp.stderr:
+                    stderr = resp.stderr
+            if targets:
+                resp = self._run_subprocess(dfs_pb2.RunRequest(target=-1, num_vertices=request.num_vertices,
+                                                               use_mpi=True, mode=dfs_pb2.TRAVERSAL_FRONTIER))
+                reached = [resp.visited_count] * len(targets)
+                runtime_ms += resp.runtime_ms
+                if resp.stderr:
+                    stderr = resp.stderr
+
+        latency_ms = (time.time() - start) * 1000.0
+        logging.info('request_ts=%s latency_ms=%.2f batch=%d found=%d', req_ts, latency_ms, len(targets), sum(found))
+
+        return dfs_pb2.BatchResponse(found=found, reached_count=reached, runtime_ms=runtime_ms, stderr=stderr)
+
+    def UpdateEdges(self, request, context):
+        req_ts = datetime.datetime.utcnow().isoformat() + 'Z'
+        start = time.time()
+        if self.daemon is None:
+            return dfs_pb2.EdgeUpdateResponse(stderr='edge updates need --daemon')
+
+        line = 'update'
+        if request.deletions:
+            line += ' delete=' + ','.join('%d:%d' % (e.from_vertex, e.to_vertex) for e in request.deletions)
+        if request.insertions:
+            line += ' insert=' + ','.join('%d:%d' % (e.from_vertex, e.to_vertex) for e in request.insertions)
+        try:
+            fields = parse_daemon_reply(self.daemon.request(line))
+            resp = dfs_pb2.EdgeUpdateResponse(inserted=int(fields['inserted']), deleted=int(fields['deleted']),
+                                              ignored=int(fields['ignored']), moved=int(fields['moved']),
+                                              components=int(fields['components']),
+                                              reached_count=int(fields['reached']),
+                                              runtime_ms=float(fields.get('runtime_ms', 0.0)))
+        except Exception as e:
+            resp = dfs_pb2.EdgeUpdateResponse(stderr=str(e))
+
+        latency_ms = (time.time() - start) * 1000.0
+        logging.info('request_ts=%s latency_ms=%.2f update inserted=%d deleted=%d moved=%d', req_ts, latency_ms,
+                     resp.inserted, resp.deleted, resp.moved)
+        return resp
+
+    def _run_subprocess(self, request):
         req_ts = datetime.datetime.utcnow().isoformat() + 'Z'
         start = time.time()
 
@@ -54,6 +331,10 @@ class DFSServiceServicer(dfs_pb2_grpc.DFSServiceServicer):
             env['NUM_VERTICES'] = str(request.num_vertices)
         if request.target:
             env['TARGET_VERTEX'] = str(request.target)
+        # StreamDFS falls back to this path without a daemon; it only
+        # reports the summary, so the frontier mode is fine there too
+        if wants_frontier(request):
+            env['TRAVERSAL_MODE'] = 'frontier'
 
         try:
             proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, env=env, timeout=self.timeout, universal_newlines=True)
@@ -114,17 +395,21 @@ class DFSServiceServicer(dfs_pb2_grpc.DFSServiceServicer):
         return dfs_pb2.RunResponse(found=found, visited_count=visited_count, runtime_ms=runtime_ms, stdout=stdout, stderr=stderr)
 
 
-def serve(port, exec_cmd, use_mpi=True, mpi_procs=4, logfile=None, timeout=120):
+def serve(port, exec_cmd, use_mpi=True, mpi_procs=4, logfile=None, timeout=120, daemon=False):
     server = grpc.server(ThreadPoolExecutor(max_workers=10))
-    dfs_pb2_grpc.add_DFSServiceServicer_to_server(DFSServiceServicer(exec_cmd, use_mpi, mpi_procs, logfile, timeout), server)
+    servicer = DFSServiceServicer(exec_cmd, use_mpi, mpi_procs, logfile, timeout, daemon)
+    dfs_pb2_grpc.add_DFSServiceServicer_to_server(servicer, server)
     listen_addr = f'[::]:{port}'
     server.add_insecure_port(listen_addr)
     server.start()
-    print(f"DFS gRPC server listening on {listen_addr} (exec={exec_cmd}, use_mpi={use_mpi}, mpi_procs={mpi_procs})")
+    print(f"DFS gRPC server listening on {listen_addr} (exec={exec_cmd}, use_mpi={use_mpi}, mpi_procs={mpi_procs}, daemon={daemon})")
     try:
         server.wait_for_termination()
     except KeyboardInterrupt:
         server.stop(0)
+    finally:
+        if servicer.daemon is not None:
+            servicer.daemon.stop()
 
 
 if __name__ == '__main__':
@@ -135,6 +420,8 @@ if __name__ == '__main__':
     parser.add_argument('--mpi-procs', type=int, default=4)
     parser.add_argument('--logfile', type=str, default=None)
     parser.add_argument('--timeout', type=int, default=120)
+    parser.add_argument('--daemon', action='store_true',
+                        help='keep a resident dfs_daemon (pass its path as --exec) instead of one process per request')
     args = parser.parse_args()
 
-    serve(args.port, args.exec_cmd, use_mpi=args.use_mpi, mpi_procs=args.mpi_procs, logfile=args.logfile, timeout=args.timeout)
+    serve(args.port, args.exec_cmd, use_mpi=args.use_mpi, mpi_procs=args.mpi_procs, logfile=args.logfile, timeout=args.timeout, daemon=args.daemon)
@@ -33,11 +33,12 @@ import dfs_pb2_grpc
 class StreamingDFSClient:
     """Handles streaming DFS requests with fault tolerance and detailed logging"""
     
-    def __init__(self, replicas, target, num_vertices, per_call_timeout=3):
+    def __init__(self, replicas, target, num_vertices, per_call_timeout=3, reachability_only=False):
         self.replicas = replicas
         self.target = target
         self.num_vertices = num_vertices
         self.per_call_timeout = per_call_timeout
+        self.reachability_only = reachability_only
         self.request_counter = 0
         self.success_counter = 0
         self.failure_counter = 0
@@ -67,7 +68,8 @@ class StreamingDFSClient:
                 req = dfs_pb2.RunRequest(
                     target=self.target,
                     num_vertices=self.num_vertices,
-                    use_mpi=True
+                    use_mpi=True,
+                    reachability_only=self.reachability_only
                 )
                 
                 # Make RPC call
@@ -155,8 +157,71 @@ class StreamingDFSClient:
         # Should never reach here, but just in case
         return None
 
+    def call_batch_with_retry(self, rows):
+        """
+        Send a whole micro-batch as one RunBatch request (one shared traversal
+        on the server) with the same failover as call_grpc_with_retry.
+        Returns: one result dict per row
+        """
+        self.request_counter += len(rows)
+        start_time = time.time()
+        start_idx = self.request_counter % len(self.replicas)
+        error_msg = None
+
+        for attempt in range(len(self.replicas)):
+            endpoint = self.replicas[(start_idx + attempt) % len(self.replicas)]
+            attempt_start = time.time()
+            try:
+                channel = grpc.insecure_channel(endpoint)
+                stub = dfs_pb2_grpc.DFSServiceStub(channel)
+                req = dfs_pb2.BatchRequest(targets=[self.target] * len(rows), num_vertices=self.num_vertices)
+                resp = stub.RunBatch(req, timeout=self.per_call_timeout)
+                if resp.stderr and not resp.found:
+                    raise RuntimeError(resp.stderr)
+
+                end_time = time.time()
+                self.success_counter += len(rows)
+                return [{
+                    'request_id': row['value'],
+                    'event_timestamp': row['timestamp'],
+                    'processing_timestamp': datetime.datetime.now().isoformat(),
+                    'endpoint': endpoint,
+                    'attempt_number': attempt + 1,
+                    'status': 'SUCCESS',
+                    'latency_ms': (end_time - attempt_start) * 1000.0,
+                    'total_latency_ms': (end_time - start_time) * 1000.0,
+                    'found': resp.found[i],
+                    'visited_count': resp.reached_count[i],
+                    'runtime_ms': resp.runtime_ms,
+                    'error_message': None
+                } for i, row in enumerate(rows)]
+            except grpc.RpcError as e:
+                error_code = e.code().name if hasattr(e, 'code') and hasattr(e.code(), 'name') else 'UNKNOWN'
+                error_msg = f"gRPC Error: {error_code}"
+            except Exception as e:
+                error_msg = str(e)[:100]
+            if attempt < len(self.replicas) - 1:
+                print(f"  ⚠ Batch of {len(rows)} → {endpoint} FAILED ({error_msg}) - Retrying on next replica...")
+
+        total_latency_ms = (time.time() - start_time) * 1000.0
+        self.failure_counter += len(rows)
+        return [{
+            'request_id': row['value'],
+            'event_timestamp': row['timestamp'],
+            'processing_timestamp': datetime.datetime.now().isoformat(),
+            'endpoint': 'ALL_REPLICAS',
+            'attempt_number': len(self.replicas),
+            'status': 'FAILED',
+            'latency_ms': 0.0,
+            'total_latency_ms': total_latency_ms,
+            'found': False,
+            'visited_count': 0,
+            'runtime_ms': 0.0,
+            'error_message': error_msg
+        } for row in rows]
+
 
-def process_batch(batch_df, batch_id, client, output_path):
+def process_batch(batch_df, batch_id, client, output_path, batched=False):
     """
     Process each micro-batch of streaming requests
     
@@ -180,6 +245,12 @@ def process_batch(batch_df, batch_id, client, output_path):
     
     # Process each request
     results = []
+    if batched:
+        print(f"\n  🚀 Sending {len(requests)} request(s) as one batch at {datetime.datetime.now().strftime('%H:%M:%S.%f')[:-3]}")
+        results = client.call_batch_with_retry(requests)
+        ok = sum(1 for r in results if r['status'] == 'SUCCESS')
+        print(f"  {'✓' if ok else '✗'} Batch → {results[0]['endpoint']} ({ok}/{len(results)} succeeded)")
+        requests = []
     for row in requests:
         request_id = row['value']
         timestamp = row['timestamp']
@@ -251,6 +322,10 @@ def main():
                         help='Timeout for each gRPC call in seconds')
     parser.add_argument('--output-log', type=str, default='streaming_logs',
                         help='Output directory for detailed CSV logs')
+    parser.add_argument('--batch', action='store_true',
+                        help='Send each micro-batch as a single RunBatch request')
+    parser.add_argument('--reachability-only', action='store_true',
+                        help='Only ask whether the target is reachable (answered from the server index)')
     
     args = parser.parse_args()
     
@@ -291,7 +366,8 @@ def main():
     print("✓ Spark Session created successfully\n")
     
     # Create client
-    client = StreamingDFSClient(replicas, args.target, args.num_vertices, args.per_call_timeout)
+    client = StreamingDFSClient(replicas, args.target, args.num_vertices, args.per_call_timeout,
+                                args.reachability_only)
     
     # Create streaming DataFrame using rate source
     # The 'rate' source generates rows with: timestamp (current time) and value (incrementing number)
@@ -308,7 +384,7 @@ def main():
     
     # Start streaming query with foreachBatch
     query = stream_df.writeStream \
-        .foreachBatch(lambda batch_df, batch_id: process_batch(batch_df, batch_id, client, args.output_log)) \
+        .foreachBatch(lambda batch_df, batch_id: process_batch(batch_df, batch_id, client, args.output_log, args.batch)) \
         .trigger(processingTime='2 seconds') \
         .start()
     
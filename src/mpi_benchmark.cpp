@@ -4,6 +4,18 @@
 #include <cmath>
 #include <iomanip>
 #include <fstream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include "graph.h"
+#include "graph_io.h"
+#include "distributed_graph.h"
+
+// mpi_benchmark [pingpong]           ping-pong latency and bandwidth, ranks 0 and 1
+// mpi_benchmark halo [scheme] [scale]
+//     the DFS's halo exchange on a real partition (GRAPH_FILE, or the
+//     circulant graph of NUM_VERTICES vertices), with each message scaled
+//     by scale to stand in for larger graphs
 
 // Latency measurement: ping-pong test
 double measureLatency(int rank, int numRanks) {
@@ -15,6 +27,11 @@ double measureLatency(int rank, int numRanks) {
         return -1.0;
     }
     
+    // Only ranks 0 and 1 take part; the rest just join the barrier
+    if (rank > 1) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        return 0.0;
+    }
     int partner = (rank == 0) ? 1 : 0;
     
     // Warmup
@@ -58,6 +75,11 @@ double measureBandwidth(int rank, int numRanks, int messageSize) {
         return -1.0;
     }
     
+    // Only ranks 0 and 1 take part; the rest just join the barrier
+    if (rank > 1) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        return 0.0;
+    }
     int partner = (rank == 0) ? 1 : 0;
     std::vector<char> sendBuffer(messageSize, 'X');
     std::vector<char> recvBuffer(messageSize);
@@ -94,6 +116,256 @@ double measureBandwidth(int rank, int numRanks, int messageSize) {
     return bandwidth;
 }
 
+// One full halo exchange of a partition: every rank sends each of its
+// ghosts once to the ghost's owner, as the DFS does over a whole traversal
+struct HaloPattern {
+    std::vector<int> sendCounts, recvCounts;
+    std::vector<int> sendOffsets, recvOffsets;
+    std::vector<int> sendBuffer, recvBuffer;
+    std::vector<int> sizeBuffer;            // incoming sizes (point-to-point)
+    std::vector<int> neighbors;             // ranks exchanged with either way, ascending
+    std::vector<int> nbrSendCounts, nbrRecvCounts, nbrSendOffsets, nbrRecvOffsets;
+    MPI_Comm neighborComm = MPI_COMM_NULL;
+};
+
+HaloPattern buildHaloPattern(const DistributedGraph& graph, int scale) {
+    int numRanks = graph.domain.numRanks;
+    HaloPattern p;
+    p.sendCounts.assign(numRanks, 0);
+    for (int owner : graph.ghostOwner) p.sendCounts[owner] += scale;
+    p.recvCounts.assign(numRanks, 0);
+    MPI_Alltoall(p.sendCounts.data(), 1, MPI_INT, p.recvCounts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+
+    p.sendOffsets.assign(numRanks, 0);
+    p.recvOffsets.assign(numRanks, 0);
+    for (int r = 1; r < numRanks; r++) {
+        p.sendOffsets[r] = p.sendOffsets[r - 1] + p.sendCounts[r - 1];
+        p.recvOffsets[r] = p.recvOffsets[r - 1] + p.recvCounts[r - 1];
+    }
+    p.sendBuffer.assign(p.sendOffsets.back() + p.sendCounts.back(), 1);
+    p.recvBuffer.assign(p.recvOffsets.back() + p.recvCounts.back(), 0);
+    p.sizeBuffer.assign(numRanks, 0);
+
+    // Symmetric neighborhood, so sizes can travel both ways on it
+    for (int r = 0; r < numRanks; r++) {
+        if (r != graph.domain.rank && (p.sendCounts[r] > 0 || p.recvCounts[r] > 0)) {
+            p.neighbors.push_back(r);
+            p.nbrSendCounts.push_back(p.sendCounts[r]);
+            p.nbrRecvCounts.push_back(p.recvCounts[r]);
+            p.nbrSendOffsets.push_back(p.sendOffsets[r]);
+            p.nbrRecvOffsets.push_back(p.recvOffsets[r]);
+        }
+    }
+    int degree = p.neighbors.size();
+    MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD, degree, p.neighbors.data(), MPI_UNWEIGHTED,
+                                   degree, p.neighbors.data(), MPI_UNWEIGHTED, MPI_INFO_NULL, 0,
+                                   &p.neighborComm);
+    return p;
+}
+
+// Busy work standing in for the traversal that overlaps the exchange. It
+// makes no MPI calls, like the DFS, so it shows how far the library
+// progresses transfers on its own.
+void computeFor(double seconds) {
+    double start = MPI_Wtime();
+    volatile double work = 0;
+    while (MPI_Wtime() - start < seconds) {
+        for (int i = 0; i < 100; i++) work = work + (i * 7) % 100;
+    }
+}
+
+enum HaloMode { HALO_P2P, HALO_ALLTOALLV, HALO_NEIGHBOR, NUM_HALO_MODES };
+
+const char* haloModeName(int mode) {
+    static const char* names[NUM_HALO_MODES] = {"isend/irecv", "alltoallv", "neighbor_alltoallv"};
+    return names[mode];
+}
+
+// One exchange the way each mode would carry the DFS's traffic: sizes
+// first, since the receiver does not know them, then the data, with
+// compute seconds of work while the data is in flight
+void haloExchange(HaloPattern& p, int mode, int rank, int numRanks, double compute) {
+    if (mode == HALO_P2P) {
+        // A size to every rank, data where non-empty: the DFS exchange before
+        // it moved to neighborhood collectives
+        std::vector<MPI_Request> recvRequests, sendRequests;
+        for (int r = 0; r < numRanks; r++) {
+            if (r == rank) continue;
+            MPI_Request req;
+            MPI_Irecv(&p.sizeBuffer[r], 1, MPI_INT, r, 0, MPI_COMM_WORLD, &req);
+            recvRequests.push_back(req);
+        }
+        for (int r = 0; r < numRanks; r++) {
+            if (r == rank) continue;
+            MPI_Request req;
+            MPI_Isend(&p.sendCounts[r], 1, MPI_INT, r, 0, MPI_COMM_WORLD, &req);
+            sendRequests.push_back(req);
+            if (p.sendCounts[r] > 0) {
+                MPI_Isend(&p.sendBuffer[p.sendOffsets[r]], p.sendCounts[r], MPI_INT, r, 1,
+                          MPI_COMM_WORLD, &req);
+                sendRequests.push_back(req);
+            }
+        }
+        computeFor(compute);
+        MPI_Waitall(recvRequests.size(), recvRequests.data(), MPI_STATUSES_IGNORE);
+        recvRequests.clear();
+        for (int r = 0; r < numRanks; r++) {
+            if (r == rank || p.sizeBuffer[r] == 0) continue;
+            MPI_Request req;
+            MPI_Irecv(&p.recvBuffer[p.recvOffsets[r]], p.sizeBuffer[r], MPI_INT, r, 1,
+                      MPI_COMM_WORLD, &req);
+            recvRequests.push_back(req);
+        }
+        MPI_Waitall(recvRequests.size(), recvRequests.data(), MPI_STATUSES_IGNORE);
+        MPI_Waitall(sendRequests.size(), sendRequests.data(), MPI_STATUSES_IGNORE);
+    } else if (mode == HALO_ALLTOALLV) {
+        std::vector<int> counts(numRanks);
+        MPI_Alltoall(p.sendCounts.data(), 1, MPI_INT, counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+        MPI_Request req;
+        MPI_Ialltoallv(p.sendBuffer.data(), p.sendCounts.data(), p.sendOffsets.data(), MPI_INT,
+                       p.recvBuffer.data(), counts.data(), p.recvOffsets.data(), MPI_INT,
+                       MPI_COMM_WORLD, &req);
+        computeFor(compute);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+    } else {
+        std::vector<int> counts(p.neighbors.size());
+        MPI_Neighbor_alltoall(p.nbrSendCounts.data(), 1, MPI_INT, counts.data(), 1, MPI_INT,
+                              p.neighborComm);
+        MPI_Request req;
+        MPI_Ineighbor_alltoallv(p.sendBuffer.data(), p.nbrSendCounts.data(), p.nbrSendOffsets.data(),
+                                MPI_INT, p.recvBuffer.data(), counts.data(), p.nbrRecvOffsets.data(),
+                                MPI_INT, p.neighborComm, &req);
+        computeFor(compute);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+    }
+}
+
+// Median over iterations of the slowest rank's exchange time
+double measureHalo(HaloPattern& p, int mode, int rank, int numRanks, double compute) {
+    const int iterations = 50;
+    const int warmup = 5;
+    std::vector<double> times;
+    for (int i = 0; i < warmup + iterations; i++) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        double start = MPI_Wtime();
+        haloExchange(p, mode, rank, numRanks, compute);
+        double local = MPI_Wtime() - start;
+        double slowest = 0;
+        MPI_Allreduce(&local, &slowest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        if (i >= warmup) times.push_back(slowest);
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int runHaloBenchmark(int argc, char** argv, int rank, int numRanks) {
+    PartitionScheme scheme = PartitionScheme::Block;
+    if (argc >= 3 && !parsePartitionScheme(argv[2], scheme)) {
+        if (rank == 0) {
+            std::cerr << "unknown partition scheme: " << argv[2] << " (use block, bfs, rcm or lp)" << std::endl;
+        }
+        return 1;
+    }
+    int scale = argc >= 4 ? std::max(1, atoi(argv[3])) : 1;
+
+    int numVertices = 50000;
+    if (rank == 0) {
+        if (const char* env = getenv("NUM_VERTICES")) numVertices = atoi(env);
+    }
+    CSRGraph fileGraph;
+    const char* graphFile = graphFileFromEnv();
+    if (graphFile) {
+        std::string error;
+        if (!mapGraphFile(graphFile, fileGraph, error)) {
+            std::cerr << "rank " << rank << ": " << error << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        numVertices = fileGraph.size();
+    }
+    MPI_Bcast(&numVertices, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    auto circulant = circulantEdges(numVertices);
+    auto edges = [&](int v, auto&& emit) {
+        if (graphFile) {
+            for (int u : fileGraph[v]) emit(u);
+        } else {
+            circulant(v, emit);
+        }
+    };
+    DistributedGraph graph = partitionAndBuild(numVertices, rank, numRanks, scheme, edges);
+    HaloPattern pattern = buildHaloPattern(graph, scale);
+
+    // Link parameters for the postal model, from the ping-pong tests
+    double latency = measureLatency(rank, numRanks);
+    double bandwidth = measureBandwidth(rank, numRanks, 1048576);
+    MPI_Bcast(&latency, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&bandwidth, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    // Per rank: data messages, neighbors and bytes sent and received
+    long long sentBytes = 0, recvBytes = 0;
+    int dataMessages = 0, recvMessages = 0;
+    for (int r = 0; r < numRanks; r++) {
+        sentBytes += (long long)pattern.sendCounts[r] * sizeof(int);
+        recvBytes += (long long)pattern.recvCounts[r] * sizeof(int);
+        dataMessages += pattern.sendCounts[r] > 0;
+        recvMessages += pattern.recvCounts[r] > 0;
+    }
+    // The slowest rank bounds the exchange: max of sending and receiving
+    // side, each alpha per message plus bytes over bandwidth
+    double p2pMessages = (numRanks - 1) + std::max(dataMessages, recvMessages);
+    double bytesModel = std::max(sentBytes, recvBytes) / (bandwidth / 2.0);
+    double localModel[NUM_HALO_MODES] = {
+        p2pMessages * latency + bytesModel,
+        (numRanks - 1) * 2.0 * latency + bytesModel,
+        pattern.neighbors.size() * 2.0 * latency + bytesModel};
+    double model[NUM_HALO_MODES];
+    MPI_Reduce(localModel, model, NUM_HALO_MODES, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    long long localStats[2] = {std::max(sentBytes, recvBytes), (long long)pattern.neighbors.size()};
+    long long maxStats[2], sumStats[2];
+    MPI_Reduce(localStats, maxStats, 2, MPI_LONG_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(localStats, sumStats, 2, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        std::cout << "===========================================" << std::endl;
+        std::cout << "MPI Halo Exchange Benchmark" << std::endl;
+        std::cout << "===========================================" << std::endl;
+        std::cout << "Number of processes: " << numRanks << std::endl;
+        std::cout << "Graph: " << (graphFile ? graphFile : "circulant") << ", " << numVertices
+                  << " vertices, " << partitionSchemeName(scheme) << " partition, message scale "
+                  << scale << std::endl;
+        std::cout << "Halo per rank: max " << maxStats[0] << " bytes (mean " << sumStats[0] / numRanks
+                  << "), max " << maxStats[1] << " neighbor ranks (mean " << std::fixed
+                  << std::setprecision(1) << (double)sumStats[1] / numRanks << ")" << std::endl;
+        std::cout << "Postal model: latency " << std::setprecision(2) << latency * 1e6 << " us, bandwidth "
+                  << bandwidth / (1024.0 * 1024.0) << " MB/s" << std::endl;
+        std::cout << std::endl;
+        std::cout << "Overlap = share of the shorter of exchange and compute hidden behind the other"
+                  << std::endl;
+        std::cout << std::left << std::setw(22) << "Mode" << std::right << std::setw(14) << "Exchange (us)"
+                  << std::setw(12) << "Model (us)" << std::setw(16) << "+Compute (us)"
+                  << std::setw(11) << "Overlap" << std::endl;
+        std::cout << "------------------------------------------------------------------------------" << std::endl;
+    }
+
+    for (int mode = 0; mode < NUM_HALO_MODES; mode++) {
+        double exchange = measureHalo(pattern, mode, rank, numRanks, 0.0);
+        // Compute as long as the exchange, the case where overlap matters most
+        double compute = std::max(exchange, 1e-6);
+        double both = measureHalo(pattern, mode, rank, numRanks, compute);
+        double hidden = exchange + compute - both;
+        double overlap = std::min(1.0, std::max(0.0, hidden / std::min(exchange, compute)));
+        if (rank == 0) {
+            std::cout << std::left << std::setw(22) << haloModeName(mode) << std::right << std::fixed
+                      << std::setprecision(2) << std::setw(14) << exchange * 1e6
+                      << std::setw(12) << model[mode] * 1e6 << std::setw(16) << both * 1e6
+                      << std::setw(10) << std::setprecision(1) << overlap * 100.0 << "%" << std::endl;
+        }
+    }
+
+    MPI_Comm_free(&pattern.neighborComm);
+    return 0;
+}
+
 int main(int argc, char** argv) {
     MPI_Init(&argc, &argv);
     
@@ -109,6 +381,20 @@ int main(int argc, char** argv) {
         return 1;
     }
     
+    std::string mode = argc >= 2 ? argv[1] : "pingpong";
+    if (mode == "halo") {
+        int status = runHaloBenchmark(argc, argv, rank, numRanks);
+        MPI_Finalize();
+        return status;
+    }
+    if (mode != "pingpong") {
+        if (rank == 0) {
+            std::cerr << "unknown mode: " << mode << " (use pingpong or halo)" << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    
     // Latency measurement
     double latency = measureLatency(rank, numRanks);
     double maxLatency = 0.0;
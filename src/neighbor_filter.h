@@ -0,0 +1,190 @@
+#ifndef NEIGHBOR_FILTER_H
+#define NEIGHBOR_FILTER_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define NEIGHBOR_FILTER_X86 1
+#endif
+
+// Bulk neighbor filter for high-degree rows. One pass over nbrs[0..count)
+// splits it into
+//   localOut:  neighbors u with lo <= u < hi that are not visited, i.e.
+//              stamps[u - lo] != epoch, in row order
+//   remoteOut: neighbors outside [lo, hi) (ghosts / other ranks' vertices)
+// stamps may be null, which makes it a plain bulk isLocalVertex split.
+// Both outputs need room for count + NEIGHBOR_FILTER_SLACK ints, since the
+// vector kernels store whole registers.
+//
+// The AVX-512 and AVX2 kernels gather the visited stamps of a block of
+// neighbors, compare them with the epoch and compact the survivors
+// (compress store, or a permutation table on AVX2). The kernel is picked
+// once per process from the CPU; NEIGHBOR_FILTER=scalar|avx2|avx512
+// overrides it (an unsupported choice falls back to scalar).
+const int NEIGHBOR_FILTER_SLACK = 16;
+
+struct FilterCounts {
+    int local = 0;
+    int remote = 0;
+};
+
+typedef FilterCounts (*NeighborFilterFn)(const int* nbrs, int count, int lo, int hi,
+                                         const uint32_t* stamps, uint32_t epoch,
+                                         int* localOut, int* remoteOut);
+
+inline FilterCounts filterNeighborsScalar(const int* nbrs, int count, int lo, int hi,
+                                          const uint32_t* stamps, uint32_t epoch,
+                                          int* localOut, int* remoteOut) {
+    FilterCounts counts;
+    for (int i = 0; i < count; i++) {
+        int u = nbrs[i];
+        if (u < lo || u >= hi) {
+            remoteOut[counts.remote++] = u;
+            continue;
+        }
+        bool visited = stamps && stamps[u - lo] == epoch;
+        localOut[counts.local] = u;
+        counts.local += !visited;
+    }
+    return counts;
+}
+
+#ifdef NEIGHBOR_FILTER_X86
+
+// Lane order that moves the lanes selected by an 8-bit mask to the front
+struct CompactTable {
+    int lanes[256][8];
+
+    CompactTable() {
+        for (int mask = 0; mask < 256; mask++) {
+            int k = 0;
+            for (int lane = 0; lane < 8; lane++) {
+                if (mask & (1 << lane)) lanes[mask][k++] = lane;
+            }
+            while (k < 8) lanes[mask][k++] = 0;
+        }
+    }
+};
+
+inline const CompactTable& compactTable() {
+    static const CompactTable table;
+    return table;
+}
+
+__attribute__((target("avx2")))
+inline FilterCounts filterNeighborsAVX2(const int* nbrs, int count, int lo, int hi,
+                                        const uint32_t* stamps, uint32_t epoch,
+                                        int* localOut, int* remoteOut) {
+    const CompactTable& table = compactTable();
+    const int* stampWords = reinterpret_cast<const int*>(stamps);
+    const __m256i below = _mm256_set1_epi32(lo - 1);
+    const __m256i limit = _mm256_set1_epi32(hi);
+    const __m256i base = _mm256_set1_epi32(lo);
+    const __m256i current = _mm256_set1_epi32(epoch);
+    const __m256i ones = _mm256_set1_epi32(-1);
+
+    FilterCounts counts;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(nbrs + i));
+        __m256i inRange = _mm256_and_si256(_mm256_cmpgt_epi32(v, below), _mm256_cmpgt_epi32(limit, v));
+        __m256i keep = inRange;
+        if (stamps) {
+            // Out-of-range lanes are masked off, so they never load
+            __m256i stamp = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), stampWords,
+                                                        _mm256_sub_epi32(v, base), inRange, 4);
+            keep = _mm256_andnot_si256(_mm256_cmpeq_epi32(stamp, current), inRange);
+        }
+        __m256i remote = _mm256_xor_si256(inRange, ones);
+
+        int keepMask = _mm256_movemask_ps(_mm256_castsi256_ps(keep));
+        int remoteMask = _mm256_movemask_ps(_mm256_castsi256_ps(remote));
+        __m256i keepLanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(table.lanes[keepMask]));
+        __m256i remoteLanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(table.lanes[remoteMask]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(localOut + counts.local),
+                            _mm256_permutevar8x32_epi32(v, keepLanes));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(remoteOut + counts.remote),
+                            _mm256_permutevar8x32_epi32(v, remoteLanes));
+        counts.local += __builtin_popcount(keepMask);
+        counts.remote += __builtin_popcount(remoteMask);
+    }
+    FilterCounts tail = filterNeighborsScalar(nbrs + i, count - i, lo, hi, stamps, epoch,
+                                              localOut + counts.local, remoteOut + counts.remote);
+    counts.local += tail.local;
+    counts.remote += tail.remote;
+    return counts;
+}
+
+__attribute__((target("avx512f")))
+inline FilterCounts filterNeighborsAVX512(const int* nbrs, int count, int lo, int hi,
+                                          const uint32_t* stamps, uint32_t epoch,
+                                          int* localOut, int* remoteOut) {
+    const __m512i first = _mm512_set1_epi32(lo);
+    const __m512i limit = _mm512_set1_epi32(hi);
+    const __m512i current = _mm512_set1_epi32(epoch);
+
+    FilterCounts counts;
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i v = _mm512_loadu_si512(nbrs + i);
+        __mmask16 inRange = _mm512_cmpge_epi32_mask(v, first) & _mm512_cmplt_epi32_mask(v, limit);
+        __mmask16 keep = inRange;
+        if (stamps) {
+            __m512i stamp = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), inRange,
+                                                        _mm512_sub_epi32(v, first), stamps, 4);
+            keep = inRange & ~_mm512_cmpeq_epi32_mask(stamp, current);
+        }
+        __mmask16 remote = ~inRange;
+
+        _mm512_mask_compressstoreu_epi32(localOut + counts.local, keep, v);
+        _mm512_mask_compressstoreu_epi32(remoteOut + counts.remote, remote, v);
+        counts.local += __builtin_popcount(keep);
+        counts.remote += __builtin_popcount(remote);
+    }
+    FilterCounts tail = filterNeighborsScalar(nbrs + i, count - i, lo, hi, stamps, epoch,
+                                              localOut + counts.local, remoteOut + counts.remote);
+    counts.local += tail.local;
+    counts.remote += tail.remote;
+    return counts;
+}
+
+#endif
+
+struct NeighborFilterChoice {
+    NeighborFilterFn fn;
+    const char* name;
+};
+
+inline NeighborFilterChoice selectNeighborFilter() {
+    const char* forced = std::getenv("NEIGHBOR_FILTER");
+#ifdef NEIGHBOR_FILTER_X86
+    __builtin_cpu_init();
+    bool avx512 = __builtin_cpu_supports("avx512f");
+    bool avx2 = __builtin_cpu_supports("avx2");
+    if (forced && *forced) {
+        avx512 = avx512 && std::strcmp(forced, "avx512") == 0;
+        avx2 = avx2 && std::strcmp(forced, "avx2") == 0;
+    }
+    if (avx512) return {filterNeighborsAVX512, "avx512"};
+    if (avx2) return {filterNeighborsAVX2, "avx2"};
+#endif
+    (void)forced;
+    return {filterNeighborsScalar, "scalar"};
+}
+
+inline const NeighborFilterChoice& neighborFilter() {
+    static const NeighborFilterChoice choice = selectNeighborFilter();
+    return choice;
+}
+
+inline const char* neighborFilterName() { return neighborFilter().name; }
+
+inline FilterCounts filterNeighbors(const int* nbrs, int count, int lo, int hi,
+                                    const uint32_t* stamps, uint32_t epoch,
+                                    int* localOut, int* remoteOut) {
+    return neighborFilter().fn(nbrs, count, lo, hi, stamps, epoch, localOut, remoteOut);
+}
+
+#endif
@@ -0,0 +1,390 @@
+#ifndef NUMA_TOPOLOGY_H
+#define NUMA_TOPOLOGY_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <omp.h>
+#include "graph.h"
+#include "atomic_bitmap.h"
+
+// NUMA-aware placement for the shared-memory engine: which CPUs sit on
+// which node, where each worker thread runs (THREAD_AFFINITY), and where
+// the graph and visited bitmap live (NUMA_PLACEMENT). Each node owns one
+// contiguous block of vertices, with edges in proportion to its threads.
+// Its threads start their DFS trees there, and first-touch placement puts
+// the block's offsets, neighbors and visited words in that node's memory.
+// No libnuma: the topology comes from sysfs, interleaving from mbind.
+
+// "0-3,8,10-11" -> 0 1 2 3 8 10 11
+inline bool parseCpuList(const std::string& text, std::vector<int>& cpus) {
+    cpus.clear();
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        char* end = nullptr;
+        long first = std::strtol(item.c_str(), &end, 10);
+        long last = first;
+        if (end == item.c_str() || first < 0) return false;
+        if (*end == '-') {
+            const char* second = end + 1;
+            last = std::strtol(second, &end, 10);
+            if (end == second || last < first) return false;
+        }
+        if (*end != '\0' && *end != '\n') return false;
+        for (long cpu = first; cpu <= last; cpu++) cpus.push_back((int)cpu);
+    }
+    return !cpus.empty();
+}
+
+// Nodes with at least one CPU this process may run on, densely numbered.
+// Without /sys/devices/system/node (or with NUMA off) that is one node
+// holding every allowed CPU.
+struct NumaTopology {
+    std::vector<std::vector<int>> nodeCpus;   // ascending CPU ids
+    std::vector<int> nodeIds;                 // kernel node id, for mbind
+
+    int numNodes() const { return nodeCpus.size(); }
+
+    int numCpus() const {
+        int total = 0;
+        for (const std::vector<int>& cpus : nodeCpus) total += cpus.size();
+        return total;
+    }
+
+    // -1 for a CPU this process may not use
+    int nodeOfCpu(int cpu) const {
+        for (int node = 0; node < numNodes(); node++) {
+            const std::vector<int>& cpus = nodeCpus[node];
+            if (std::binary_search(cpus.begin(), cpus.end(), cpu)) return node;
+        }
+        return -1;
+    }
+};
+
+inline NumaTopology detectNumaTopology() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &allowed);
+    }
+
+    NumaTopology topology;
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string line;
+    std::vector<int> nodes;
+    if (std::getline(online, line) && parseCpuList(line, nodes)) {
+        for (int id : nodes) {
+            std::ifstream list("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+            std::vector<int> cpus, usable;
+            if (std::getline(list, line) && parseCpuList(line, cpus)) {
+                for (int cpu : cpus) {
+                    if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) usable.push_back(cpu);
+                }
+            }
+            if (usable.empty()) continue;   // memory-only node, or none of ours
+            topology.nodeCpus.push_back(usable);
+            topology.nodeIds.push_back(id);
+        }
+    }
+    if (topology.nodeCpus.empty()) {
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+        }
+        topology.nodeCpus.push_back(cpus);
+        topology.nodeIds.push_back(0);
+    }
+    return topology;
+}
+
+// Where each worker thread runs and which node it counts as
+struct ThreadLayout {
+    std::string affinity = "none";
+    std::vector<int> cpu;       // -1: not pinned
+    std::vector<int> node;      // dense node index
+    int numNodes = 1;
+
+    int numThreads() const { return node.size(); }
+    bool pinned() const { return !cpu.empty() && cpu[0] >= 0; }
+
+    // Binds the calling thread to tid's CPU; a no-op for unpinned layouts
+    bool pin(int tid) const {
+        if (tid >= (int)cpu.size() || cpu[tid] < 0) return true;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu[tid], &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+};
+
+// THREAD_AFFINITY values:
+//   none     no pinning (the OS, or OMP_PROC_BIND, decides)
+//   compact  fill node 0's CPUs, then node 1's, ...
+//   scatter  thread t on node t % nodes, round robin over its CPUs
+//   <list>   explicit CPU per thread, e.g. "0,8,1,9" or "0-7,16-23";
+//            threads past the end wrap around
+// Unpinned threads are assigned nodes in contiguous groups (threads
+// 0 .. k-1 to node 0, and so on), as OMP_PROC_BIND=close would place them.
+// Returns false for a malformed list or a CPU this process may not use.
+inline bool makeThreadLayout(const NumaTopology& topology, int numThreads, const std::string& affinity,
+                             ThreadLayout& layout) {
+    numThreads = std::max(1, numThreads);
+    int nodes = topology.numNodes();
+    layout = ThreadLayout();
+    layout.affinity = affinity.empty() ? "none" : affinity;
+    layout.numNodes = nodes;
+    layout.cpu.assign(numThreads, -1);
+    layout.node.assign(numThreads, 0);
+
+    if (layout.affinity == "none") {
+        for (int t = 0; t < numThreads; t++) layout.node[t] = (long long)t * nodes / numThreads;
+        return true;
+    }
+    if (layout.affinity == "compact") {
+        std::vector<int> order;
+        for (const std::vector<int>& cpus : topology.nodeCpus) order.insert(order.end(), cpus.begin(), cpus.end());
+        for (int t = 0; t < numThreads; t++) layout.cpu[t] = order[t % order.size()];
+    } else if (layout.affinity == "scatter") {
+        for (int t = 0; t < numThreads; t++) {
+            const std::vector<int>& cpus = topology.nodeCpus[t % nodes];
+            layout.cpu[t] = cpus[(t / nodes) % cpus.size()];
+        }
+    } else {
+        std::vector<int> list;
+        if (!parseCpuList(layout.affinity, list)) return false;
+        for (int t = 0; t < numThreads; t++) layout.cpu[t] = list[t % list.size()];
+    }
+    for (int t = 0; t < numThreads; t++) {
+        layout.node[t] = topology.nodeOfCpu(layout.cpu[t]);
+        if (layout.node[t] < 0) return false;
+    }
+    return true;
+}
+
+// Lets numThreads OpenMP threads run on every CPU of topology again
+inline void unpinThreads(const NumaTopology& topology, int numThreads) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const std::vector<int>& cpus : topology.nodeCpus) {
+        for (int cpu : cpus) CPU_SET(cpu, &set);
+    }
+    #pragma omp parallel num_threads(numThreads)
+    {
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+}
+
+inline bool threadLayoutFromEnv(const NumaTopology& topology, int numThreads, ThreadLayout& layout) {
+    const char* affinity = std::getenv("THREAD_AFFINITY");
+    return makeThreadLayout(topology, numThreads, affinity ? affinity : "", layout);
+}
+
+// Where the graph arrays and the visited bitmap are allocated
+enum class MemoryPlacement {
+    Default,        // wherever the building thread touched them first
+    FirstTouch,     // each node's vertex block on that node
+    Interleave      // pages spread round robin over all nodes
+};
+
+inline bool parseMemoryPlacement(const std::string& name, MemoryPlacement& placement) {
+    if (name == "default") {
+        placement = MemoryPlacement::Default;
+    } else if (name == "firsttouch") {
+        placement = MemoryPlacement::FirstTouch;
+    } else if (name == "interleave") {
+        placement = MemoryPlacement::Interleave;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline const char* memoryPlacementName(MemoryPlacement placement) {
+    switch (placement) {
+        case MemoryPlacement::FirstTouch: return "firsttouch";
+        case MemoryPlacement::Interleave: return "interleave";
+        default: return "default";
+    }
+}
+
+// NUMA_PLACEMENT (default, firsttouch or interleave); false for an unknown name
+inline bool memoryPlacementFromEnv(MemoryPlacement& placement) {
+    placement = MemoryPlacement::Default;
+    const char* name = std::getenv("NUMA_PLACEMENT");
+    return !name || !*name || parseMemoryPlacement(name, placement);
+}
+
+// Node k owns vertices [blocks[k], blocks[k + 1]), with edges split in
+// proportion to the node's threads (so a node without threads owns none)
+inline std::vector<int> nodeVertexBlocks(const CSRGraph& adj, const ThreadLayout& layout) {
+    std::vector<int> blocks(layout.numNodes + 1, adj.size());
+    blocks[0] = 0;
+    const int64_t* offsets = adj.offsets.data();
+    int64_t edges = adj.numEdges();
+    long long threadsBefore = 0;
+    for (int k = 1; k < layout.numNodes; k++) {
+        threadsBefore += std::count(layout.node.begin(), layout.node.end(), k - 1);
+        int64_t goal = edges * threadsBefore / layout.numThreads();
+        blocks[k] = std::lower_bound(offsets, offsets + adj.size(), goal) - offsets;
+        blocks[k] = std::max(blocks[k], blocks[k - 1]);
+    }
+    return blocks;
+}
+
+// The share of node's block that thread tid (one of the node's threads)
+// first touches: [first, last)
+inline void threadShare(const ThreadLayout& layout, const std::vector<int>& blocks, int tid,
+                        int& first, int& last) {
+    int node = layout.node[tid];
+    int index = 0, count = 0;
+    for (int t = 0; t < layout.numThreads(); t++) {
+        if (layout.node[t] != node) continue;
+        if (t < tid) index++;
+        count++;
+    }
+    long long size = blocks[node + 1] - blocks[node];
+    first = blocks[node] + size * index / count;
+    last = blocks[node] + size * (index + 1) / count;
+}
+
+// Runs body(tid) once for every thread of layout, each on its own CPU.
+// An OpenMP team smaller than the layout still covers every tid.
+template <typename Body>
+void forEachLayoutThread(const ThreadLayout& layout, Body body) {
+    int numThreads = layout.numThreads();
+    #pragma omp parallel num_threads(numThreads)
+    {
+        int team = omp_get_num_threads();
+        for (int tid = omp_get_thread_num(); tid < numThreads; tid += team) {
+            layout.pin(tid);
+            body(tid);
+        }
+    }
+}
+
+// Page-aligned memory that no thread has touched yet, so its pages land
+// where they are first written (or where mbind says)
+class PlacedBuffer {
+public:
+    explicit PlacedBuffer(size_t bytes) : bytes_(std::max<size_t>(bytes, 1)) {
+        void* data = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        data_ = data == MAP_FAILED ? nullptr : data;
+    }
+
+    ~PlacedBuffer() {
+        if (data_) munmap(data_, bytes_);
+    }
+
+    PlacedBuffer(const PlacedBuffer&) = delete;
+    PlacedBuffer& operator=(const PlacedBuffer&) = delete;
+
+    void* data() const { return data_; }
+
+private:
+    void* data_;
+    size_t bytes_;
+};
+
+// Spreads the pages of [data, data + bytes) over all nodes, rounded inward
+// to whole pages. Takes effect for pages not yet touched.
+inline bool interleavePages(const void* data, size_t bytes, const NumaTopology& topology,
+                            std::string& error) {
+    if (topology.numNodes() < 2) return true;
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t first = ((uintptr_t)data + page - 1) & ~(page - 1);
+    uintptr_t last = ((uintptr_t)data + bytes) & ~(page - 1);
+    if (last <= first) return true;
+
+    int maxNode = *std::max_element(topology.nodeIds.begin(), topology.nodeIds.end());
+    const int bitsPerWord = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(maxNode / bitsPerWord + 1, 0);
+    for (int id : topology.nodeIds) mask[id / bitsPerWord] |= 1UL << (id % bitsPerWord);
+    const int MPOL_INTERLEAVE_MODE = 3;     // MPOL_INTERLEAVE in linux/mempolicy.h
+    if (syscall(SYS_mbind, first, last - first, MPOL_INTERLEAVE_MODE, mask.data(),
+                (unsigned long)(maxNode + 2), 0) != 0) {
+        error = std::string("mbind: ") + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+// Copies adj into fresh pages placed per placement: each node's vertex
+// block on that node (FirstTouch) or spread over all nodes (Interleave).
+// placed's arrays become read-only views of the copies; placed may be adj
+// itself. On failure placed is left as it was.
+inline bool placeGraph(const CSRGraph& adj, MemoryPlacement placement, const NumaTopology& topology,
+                       const ThreadLayout& layout, CSRGraph& placed, std::string& error) {
+    if (placement == MemoryPlacement::Default) {
+        if (&placed != &adj) placed = adj;
+        return true;
+    }
+    int n = adj.size();
+    int64_t edges = adj.numEdges();
+    auto offsetMemory = std::make_shared<PlacedBuffer>((n + 1) * sizeof(int64_t));
+    auto neighborMemory = std::make_shared<PlacedBuffer>(edges * sizeof(int));
+    if (!offsetMemory->data() || !neighborMemory->data()) {
+        error = "mmap failed for the placed graph";
+        return false;
+    }
+    int64_t* offsets = static_cast<int64_t*>(offsetMemory->data());
+    int* neighbors = static_cast<int*>(neighborMemory->data());
+    if (placement == MemoryPlacement::Interleave &&
+        (!interleavePages(offsets, (n + 1) * sizeof(int64_t), topology, error) ||
+         !interleavePages(neighbors, edges * sizeof(int), topology, error))) {
+        return false;
+    }
+
+    const int64_t* fromOffsets = adj.offsets.data();
+    const int* fromNeighbors = adj.neighbors.data();
+    std::vector<int> blocks = nodeVertexBlocks(adj, layout);
+    forEachLayoutThread(layout, [&](int tid) {
+        int first, last;
+        threadShare(layout, blocks, tid, first, last);
+        std::copy(fromOffsets + first, fromOffsets + last, offsets + first);
+        std::copy(fromNeighbors + fromOffsets[first], fromNeighbors + fromOffsets[last],
+                  neighbors + fromOffsets[first]);
+    });
+    offsets[n] = fromOffsets[n];
+
+    placed.numVertices = n;
+    placed.offsets.setView(offsets, n + 1, offsetMemory);
+    placed.neighbors.setView(neighbors, edges, neighborMemory);
+    return true;
+}
+
+// A cleared visited bitmap for adj whose words sit with their vertices'
+// node (FirstTouch) or spread over all nodes (Interleave)
+inline AtomicBitmap placedBitmap(const CSRGraph& adj, MemoryPlacement placement,
+                                 const NumaTopology& topology, const ThreadLayout& layout) {
+    if (placement == MemoryPlacement::Default) return AtomicBitmap(adj.size());
+    size_t bytes = (adj.size() + 63) / 64 * sizeof(uint64_t);
+    auto memory = std::make_shared<PlacedBuffer>(bytes);
+    if (!memory->data()) return AtomicBitmap(adj.size());
+    std::string error;
+    if (placement == MemoryPlacement::Interleave) {
+        interleavePages(memory->data(), bytes, topology, error);
+    }
+    AtomicBitmap bitmap(adj.size(), memory->data(), memory);
+    std::vector<int> blocks = nodeVertexBlocks(adj, layout);
+    forEachLayoutThread(layout, [&](int tid) {
+        int first, last;
+        threadShare(layout, blocks, tid, first, last);
+        // A word straddling two shares belongs to the earlier one
+        bitmap.clearWords((first + 63) / 64, (last + 63) / 64);
+    });
+    return bitmap;
+}
+
+#endif
@@ -1,114 +1,122 @@
 #include <iostream>
 #include <vector>
+#include <cstdlib>
+#include <algorithm>
 #include <omp.h>
+#include "graph.h"
+#include "graph_io.h"
+#include "atomic_bitmap.h"
+#include "work_stealing_dfs.h"
+#include "preorder_buffers.h"
+#include "frontier_reach.h"
+#include "vertex_order.h"
+#include "numa_topology.h"
 using namespace std;
 
-void dfsRec(vector<vector<int>> &adj, vector<bool> &visited, int s, vector<int> &res, int stride) {
-    #pragma omp critical
-    {
-        if (!visited[s])
-        {
-            visited[s] = true;
-            res.push_back(s);
-        }
-    }
-
-    double work = 0;
-    for (int i = 0; i < 1000; i++)
-    {
-        work += (s * i) % 100;
-    }
+// Each thread appends to its own buffer; the merge returns the visited
+// vertices in ascending order so repeated runs produce identical output.
+// The visited bitmap is placed like the graph (NUMA_PLACEMENT).
+vector<int> dfs(const CSRGraph &adj, int stride, WorkStealingDFS &engine, ThreadLocalPreorder &buffers,
+                const NumaTopology &topology, MemoryPlacement placement)
+{
+    AtomicBitmap visited = placedBitmap(adj, placement, topology, engine.layout());
+    buffers.clear();
+
+    engine.run(adj, visited, stride, [&](int s, int parent, int tid) {
+        buffers.append(tid, s, parent);
+        syntheticWork(s);
+    });
+    return buffers.merge(adj.size(), MergeOrder::VertexOrder).order;
+}
 
-    for (int idx = 0; idx < adj[s].size(); idx += stride)
-    {
-        int i = adj[s][idx];
-        bool needsVisit = false;
+// TRAVERSAL_MODE=frontier: reachability from vertex 0 only, with no
+// preorder, so there are no strides to compare
+void runFrontier(const CSRGraph &adj, const VertexPermutation &perm)
+{
+    CSRGraph reverse = transposeGraph(adj);
+    FrontierReach engine(adj, reverse, omp_get_max_threads());
+    int source = perm.identity() ? 0 : perm.newId[0];
+
+    cout << "Frontier traversal of the graph from vertex 0 (Parallel):" << endl;
+    double start = omp_get_wtime();
+    FrontierResult result = engine.run(source, -1);
+    double end = omp_get_wtime();
+
+    cout << "Total vertices visited: " << result.visited << endl;
+    cout << "Levels: " << result.levels << " (" << result.bottomUpLevels << " bottom-up)" << endl;
+    cout << "Execution time: " << (end - start) * 1000.0 << " milliseconds (ms)" << endl;
+    cout << "Number of threads used: " << engine.numThreads() << endl;
+}
 
-        #pragma omp critical
-        {
-            needsVisit = !visited[i];
-        }
+int main(int argc, char** argv)
+{
+    int numVertices = 50000;
+    int splitThreshold = 64;
+    if (argc >= 2) {
+        splitThreshold = atoi(argv[1]);
+    }
 
-        if (needsVisit)
-        {
-            #pragma omp task shared(adj, visited, res)
-            {
-                dfsRec(adj, visited, i, res, stride);
-            }
+    CSRGraph adj;
+    if (const char* graphFile = graphFileFromEnv()) {
+        string error;
+        if (!mapGraphFile(graphFile, adj, error)) {
+            cerr << error << endl;
+            return 1;
         }
+        numVertices = adj.size();
+        cout << "Mapped graph file " << graphFile << " (" << numVertices << " vertices, "
+             << adj.numEdges() << " edges)" << endl;
+    } else {
+        cout << "Creating large graph with " << numVertices << " vertices..." << endl;
+        adj = createTestGraph(numVertices);
     }
-    
-    for (int idx = 0; idx < adj[s].size(); idx++)
-    {
-        if (idx % stride != 0)
-        {
-            int i = adj[s][idx];
-            bool needsVisit = false;
 
-            #pragma omp critical
-            {
-                needsVisit = !visited[i];
-            }
-
-            if (needsVisit) {
-                #pragma omp task shared(adj, visited, res)
-                {
-                    dfsRec(adj, visited, i, res, stride);
-                }
-            }
-        }
+    VertexOrdering ordering;
+    if (!vertexOrderingFromEnv(ordering)) {
+        cerr << "unknown VERTEX_ORDER (use original, bfs, rcm or degree)" << endl;
+        return 1;
+    }
+    VertexPermutation perm;
+    if (ordering != VertexOrdering::Original) {
+        perm = VertexPermutation(computeVertexOrder(adj, ordering));
+        adj = relabelGraph(adj, perm);
+        cout << "Relabeled vertices in " << vertexOrderingName(ordering) << " order" << endl;
     }
-    #pragma omp taskwait
-}
 
-vector<int> dfs(vector<vector<int>> &adj, int stride)
-{
-    vector<bool> visited(adj.size(), false);
-    vector<int> res;
+    cout << "Graph created successfully!" << endl;
 
-    #pragma omp parallel
-    {
-        #pragma omp single
-        {
-            for (int i = 0; i < adj.size(); i++)
-            {
-                bool needsVisit = false;
-                #pragma omp critical
-                {
-                    needsVisit = !visited[i];
-                }
-
-                if (needsVisit)
-                {
-                    dfsRec(adj, visited, i, res, stride);
-                }
-            }
-        }
+    TraversalMode mode;
+    if (!traversalModeFromEnv(mode)) {
+        cerr << "unknown TRAVERSAL_MODE (use dfs or frontier)" << endl;
+        return 1;
+    }
+    if (mode == TraversalMode::Frontier) {
+        runFrontier(adj, perm);
+        return 0;
     }
-    return res;
-}
-
-int main()
-{
-    int numVertices = 50000;
-    vector<vector<int>> adj(numVertices);
 
-    cout << "Creating large graph with " << numVertices << " vertices..." << endl;
+    WorkStealingDFS engine(omp_get_max_threads(), splitThreshold);
+    ThreadLocalPreorder buffers(engine.numThreads());
 
-    for (int i = 0; i < numVertices; i++)
-    {
-        int connections = 2 + (i % 3);
-        for (int j = 1; j <= connections; j++)
-        {
-            int neighbor = (i * 7 + j * 13) % numVertices;
-            if (neighbor != i)
-            {
-                adj[i].push_back(neighbor);
-            }
-        }
+    NumaTopology topology = detectNumaTopology();
+    ThreadLayout layout;
+    if (!threadLayoutFromEnv(topology, engine.numThreads(), layout)) {
+        cerr << "bad THREAD_AFFINITY (use none, compact, scatter or a CPU list such as 0-3,8)" << endl;
+        return 1;
     }
-
-    cout << "Graph created successfully!" << endl;
+    MemoryPlacement placement;
+    if (!memoryPlacementFromEnv(placement)) {
+        cerr << "unknown NUMA_PLACEMENT (use default, firsttouch or interleave)" << endl;
+        return 1;
+    }
+    engine.setLayout(layout);
+    string placeError;
+    if (!placeGraph(adj, placement, topology, layout, adj, placeError)) {
+        cerr << "NUMA placement failed, keeping default placement: " << placeError << endl;
+        placement = MemoryPlacement::Default;
+    }
+    cout << "NUMA nodes: " << topology.numNodes() << ", thread affinity: " << layout.affinity
+         << ", memory placement: " << memoryPlacementName(placement) << endl;
 
     int strides[] = {1, 2, 4, 8, 16};
     int num_strides = sizeof(strides) / sizeof(strides[0]);
@@ -121,13 +129,19 @@ int main()
 
         double start = omp_get_wtime();
 
-        vector<int> result = dfs(adj, stride);
+        vector<int> result = dfs(adj, stride, engine, buffers, topology, placement);
 
         double end = omp_get_wtime();
 
         double time_seconds = end - start;
         double time_ms = time_seconds * 1000.0;
 
+        // Report original vertex IDs, still in ascending order
+        if (!perm.identity()) {
+            perm.toOriginal(result);
+            sort(result.begin(), result.end());
+        }
+
         cout << "Total vertices visited: " << result.size() << endl;
         cout << "First 10 vertices: ";
         for (int i = 0; i < 10 && i < result.size(); i++)
@@ -136,7 +150,35 @@ int main()
         }
         cout << "..." << endl;
         cout << "Execution time: " << time_ms << " milliseconds (ms)" << endl;
-        cout << "Number of threads used: " << omp_get_max_threads() << endl;
+        cout << "Number of threads used: " << engine.numThreads() << endl;
+        cout << "Split threshold: " << engine.splitThreshold() << endl;
+
+        const vector<WorkerStats> &stats = engine.stats();
+        vector<long long> nodeVisited(layout.numNodes, 0);
+        for (int t = 0; t < (int)stats.size(); t++)
+        {
+            cout << "  thread " << t;
+            if (layout.pinned())
+            {
+                cout << " (cpu " << layout.cpu[t] << ")";
+            }
+            cout << ": node " << engine.nodeOf(t)
+                 << ", visited " << stats[t].visited
+                 << ", roots " << stats[t].roots
+                 << ", steals " << stats[t].steals
+                 << " (" << stats[t].remoteSteals << " remote)"
+                 << ", failed steals " << stats[t].failedSteals
+                 << ", splits " << stats[t].splits << endl;
+            nodeVisited[engine.nodeOf(t)] += stats[t].visited;
+        }
+        if (layout.numNodes > 1)
+        {
+            for (int k = 0; k < layout.numNodes; k++)
+            {
+                cout << "  node " << k << ": visited " << nodeVisited[k] << " ("
+                     << nodeVisited[k] / time_seconds / 1e6 << " Mvertices/s)" << endl;
+            }
+        }
         cout << endl;
     }
 
@@ -0,0 +1,175 @@
+#ifndef PARTITIONER_H
+#define PARTITIONER_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include "graph.h"
+#include "vertex_order.h"
+
+// Vertex -> rank ownership table produced by a partitioning scheme
+struct Partition {
+    int numRanks = 1;
+    std::vector<int> owner;     // owner[v] is the rank that stores vertex v
+};
+
+enum class PartitionScheme {
+    Block,              // contiguous ID ranges (setupDomain / findOwnerRank)
+    BFSBlock,           // contiguous ranges of a BFS relabeling
+    RCMBlock,           // contiguous ranges of a reverse Cuthill-McKee relabeling
+    LabelPropagation    // size-constrained label propagation, edge-cut driven
+};
+
+inline bool parsePartitionScheme(const std::string& name, PartitionScheme& scheme) {
+    if (name == "block") {
+        scheme = PartitionScheme::Block;
+    } else if (name == "bfs") {
+        scheme = PartitionScheme::BFSBlock;
+    } else if (name == "rcm") {
+        scheme = PartitionScheme::RCMBlock;
+    } else if (name == "lp" || name == "label-propagation") {
+        scheme = PartitionScheme::LabelPropagation;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline const char* partitionSchemeName(PartitionScheme scheme) {
+    switch (scheme) {
+    case PartitionScheme::BFSBlock: return "BFS-ordered block";
+    case PartitionScheme::RCMBlock: return "RCM-ordered block";
+    case PartitionScheme::LabelPropagation: return "label propagation";
+    default: return "1D block";
+    }
+}
+
+struct PartitionStats {
+    int64_t edgeCut = 0;            // directed edges whose endpoints differ in owner
+    int64_t totalEdges = 0;
+    int64_t boundaryVertices = 0;   // vertices with at least one remote neighbor
+    int minPartSize = 0;
+    int maxPartSize = 0;
+    double imbalance = 1.0;         // largest part / average part size
+
+    double cutFraction() const { return totalEdges ? double(edgeCut) / totalEdges : 0.0; }
+};
+
+// Same ownership as setupDomain: the first (n % P) ranks get one extra vertex
+inline Partition blockPartition(int numVertices, int numRanks) {
+    Partition part;
+    part.numRanks = numRanks;
+    part.owner.resize(numVertices);
+    int baseSize = numVertices / numRanks;
+    int remainder = numVertices % numRanks;
+    int v = 0;
+    for (int r = 0; r < numRanks; r++) {
+        int size = baseSize + (r < remainder ? 1 : 0);
+        for (int i = 0; i < size; i++) part.owner[v++] = r;
+    }
+    return part;
+}
+
+// Block ranges of a relabeled graph: position i of order goes where vertex
+// i would go in blockPartition. Ownership stays keyed by original IDs, so
+// callers (and results) never see the new labels.
+inline Partition orderedBlockPartition(const VertexOrder& order, int numRanks) {
+    Partition part = blockPartition(order.size(), numRanks);
+    std::vector<int> chunkOwner = part.owner;
+    for (size_t i = 0; i < order.size(); i++) part.owner[order[i]] = chunkOwner[i];
+    return part;
+}
+
+// Label propagation on the symmetrized graph. The initial labels come from
+// graph growing: vertices are cut into equal consecutive chunks of a BFS
+// order, which already keeps neighborhoods together when IDs carry no
+// locality. Then each vertex moves to the rank that owns most of its in-
+// and out-neighbors, as long as that rank stays under (1 + epsilon) times
+// the average size. Gains are strictly positive so the edge cut never grows.
+inline Partition labelPropagationPartition(const CSRGraph& adj, int numRanks,
+                                           int maxIterations = 10, double epsilon = 0.03) {
+    int n = adj.size();
+    if (numRanks <= 1 || n == 0) return blockPartition(n, numRanks);
+
+    Partition part = orderedBlockPartition(breadthFirstOrder(adj), numRanks);
+
+    // Reverse edges, so that a vertex also sees who points at it
+    CSRGraph reverse = transposeGraph(adj);
+
+    int capacity = (int)((1.0 + epsilon) * ((n + numRanks - 1) / numRanks));
+    std::vector<int> partSize(numRanks, 0);
+    for (int v = 0; v < n; v++) partSize[part.owner[v]]++;
+
+    std::vector<int> count(numRanks, 0);
+    std::vector<int> touched;
+    for (int iter = 0; iter < maxIterations; iter++) {
+        int64_t moves = 0;
+        for (int v = 0; v < n; v++) {
+            touched.clear();
+            auto tally = [&](int u) {
+                int r = part.owner[u];
+                if (count[r]++ == 0) touched.push_back(r);
+            };
+            for (int u : adj[v]) tally(u);
+            for (int u : reverse[v]) tally(u);
+
+            int current = part.owner[v];
+            int best = current;
+            int bestCount = count[current];
+            for (int r : touched) {
+                if (count[r] > bestCount && partSize[r] < capacity) {
+                    best = r;
+                    bestCount = count[r];
+                }
+            }
+            for (int r : touched) count[r] = 0;
+
+            if (best != current) {
+                partSize[current]--;
+                partSize[best]++;
+                part.owner[v] = best;
+                moves++;
+            }
+        }
+        if (moves == 0) break;
+    }
+    return part;
+}
+
+inline Partition computePartition(const CSRGraph& adj, int numRanks, PartitionScheme scheme) {
+    if (scheme == PartitionScheme::LabelPropagation) {
+        return labelPropagationPartition(adj, numRanks);
+    }
+    if (scheme == PartitionScheme::BFSBlock) {
+        return orderedBlockPartition(computeVertexOrder(adj, VertexOrdering::BFS), numRanks);
+    }
+    if (scheme == PartitionScheme::RCMBlock) {
+        return orderedBlockPartition(computeVertexOrder(adj, VertexOrdering::RCM), numRanks);
+    }
+    return blockPartition(adj.size(), numRanks);
+}
+
+inline PartitionStats evaluatePartition(const CSRGraph& adj, const Partition& part) {
+    PartitionStats stats;
+    std::vector<int> partSize(part.numRanks, 0);
+    for (int v = 0; v < adj.size(); v++) {
+        partSize[part.owner[v]]++;
+        bool boundary = false;
+        for (int u : adj[v]) {
+            stats.totalEdges++;
+            if (part.owner[u] != part.owner[v]) {
+                stats.edgeCut++;
+                boundary = true;
+            }
+        }
+        if (boundary) stats.boundaryVertices++;
+    }
+    stats.minPartSize = *std::min_element(partSize.begin(), partSize.end());
+    stats.maxPartSize = *std::max_element(partSize.begin(), partSize.end());
+    double average = double(adj.size()) / part.numRanks;
+    stats.imbalance = average > 0 ? stats.maxPartSize / average : 1.0;
+    return stats;
+}
+
+#endif
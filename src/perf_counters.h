@@ -0,0 +1,280 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <omp.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware counters (plus two software ones that work even where the PMU
+// is hidden, e.g. in most VMs) read with perf_event_open around measured
+// traversals. Every event is opened on its own, so a PMU that lacks one
+// event still reports the rest, and values are scaled by enabled/running
+// time if the kernel had to multiplex them. Where perf_event_open is
+// missing or forbidden (perf_event_paranoid, seccomp, non-Linux) nothing
+// opens and callers just report the reason.
+enum CounterId {
+    CNT_CYCLES,
+    CNT_INSTRUCTIONS,
+    CNT_L1D_MISSES,         // L1 data cache read misses
+    CNT_LLC_MISSES,         // last-level cache misses
+    CNT_DTLB_MISSES,        // data TLB read misses
+    CNT_BRANCH_MISSES,
+    CNT_TASK_CLOCK,         // software: ns on CPU
+    CNT_PAGE_FAULTS,        // software
+    NUM_COUNTERS
+};
+
+inline const char* counterName(int id) {
+    static const char* names[NUM_COUNTERS] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses",
+        "dtlb_misses", "branch_misses", "task_clock_ns", "page_faults"};
+    return names[id];
+}
+
+// Counter readings of one thread (or a sum of threads)
+struct CounterValues {
+    double value[NUM_COUNTERS] = {};
+    bool valid[NUM_COUNTERS] = {};
+
+    bool any() const {
+        for (bool v : valid) {
+            if (v) return true;
+        }
+        return false;
+    }
+
+    bool hardware() const {
+        for (int id = 0; id < CNT_TASK_CLOCK; id++) {
+            if (valid[id]) return true;
+        }
+        return false;
+    }
+
+    double ipc() const {
+        return valid[CNT_CYCLES] && valid[CNT_INSTRUCTIONS] && value[CNT_CYCLES] > 0
+            ? value[CNT_INSTRUCTIONS] / value[CNT_CYCLES] : 0.0;
+    }
+
+    // A counter stays valid in a sum only if every part had it
+    void accumulate(const CounterValues& other, bool first) {
+        for (int id = 0; id < NUM_COUNTERS; id++) {
+            value[id] += other.value[id];
+            valid[id] = first ? other.valid[id] : valid[id] && other.valid[id];
+        }
+    }
+
+    void scale(double factor) {
+        for (double& v : value) v *= factor;
+    }
+};
+
+#ifdef __linux__
+inline void counterAttr(int id, perf_event_attr& attr) {
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    auto cache = [](uint64_t cacheId, uint64_t result) {
+        return cacheId | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+    };
+    switch (id) {
+    case CNT_CYCLES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case CNT_INSTRUCTIONS:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case CNT_L1D_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS);
+        break;
+    case CNT_LLC_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+    case CNT_DTLB_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_RESULT_MISS);
+        break;
+    case CNT_BRANCH_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    case CNT_TASK_CLOCK:
+        attr.type = PERF_TYPE_SOFTWARE;
+        attr.config = PERF_COUNT_SW_TASK_CLOCK;
+        break;
+    default:
+        attr.type = PERF_TYPE_SOFTWARE;
+        attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+        break;
+    }
+}
+#endif
+
+// The counters of the thread that constructs it
+class ThreadCounters {
+public:
+    ThreadCounters() {
+        for (int id = 0; id < NUM_COUNTERS; id++) fds_[id] = -1;
+#ifdef __linux__
+        for (int id = 0; id < NUM_COUNTERS; id++) {
+            perf_event_attr attr;
+            counterAttr(id, attr);
+            fds_[id] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            if (fds_[id] < 0 && error_.empty()) {
+                error_ = std::string(counterName(id)) + ": " + std::strerror(errno);
+            }
+        }
+#else
+        error_ = "perf_event_open needs Linux";
+#endif
+    }
+
+    ~ThreadCounters() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    ThreadCounters(const ThreadCounters&) = delete;
+    ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+    bool opened(int id) const { return fds_[id] >= 0; }
+
+    bool anyOpened() const {
+        for (int fd : fds_) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+
+    // First event that failed to open, empty if all did
+    const std::string& error() const { return error_; }
+
+    // ioctl works on the descriptors from any thread, so one thread can
+    // switch a whole team's counters on and off
+    void start() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+#endif
+    }
+
+    CounterValues read() const {
+        CounterValues values;
+#ifdef __linux__
+        for (int id = 0; id < NUM_COUNTERS; id++) {
+            uint64_t data[3];   // value, time enabled, time running
+            if (fds_[id] < 0 || ::read(fds_[id], data, sizeof(data)) != sizeof(data)) continue;
+            if (data[2] == 0 && data[1] > 0) continue;  // enabled but never scheduled
+            values.value[id] = data[2] < data[1] ? double(data[0]) * data[1] / data[2] : double(data[0]);
+            values.valid[id] = true;
+        }
+#endif
+        return values;
+    }
+
+private:
+    int fds_[NUM_COUNTERS];
+    std::string error_;
+};
+
+// Counters for every thread of an OpenMP team of numThreads. Each thread
+// opens its own events (perf counts the calling thread), so the measured
+// parallel regions must run with the same team size, on the same pool
+// threads, which OpenMP runtimes keep between regions. The serial engines
+// use a team of one, i.e. the calling thread.
+class PerfCounters {
+public:
+    explicit PerfCounters(int numThreads) : threads_(numThreads < 1 ? 1 : numThreads) {
+        int team = threads_.size();
+        if (team == 1) {
+            threads_[0].reset(new ThreadCounters());
+        } else {
+            #pragma omp parallel num_threads(team)
+            {
+                int tid = omp_get_thread_num();
+                if (tid < team) threads_[tid].reset(new ThreadCounters());
+            }
+        }
+    }
+
+    int numThreads() const { return threads_.size(); }
+
+    // True if some event opened on every thread of the team
+    bool available() const { return unavailableReason().empty(); }
+
+    std::string unavailableReason() const {
+        for (const auto& t : threads_) {
+            if (!t) return "OpenMP team smaller than requested";
+            if (!t->anyOpened()) return t->error();
+        }
+        return "";
+    }
+
+    // The first event that could not be opened (the rest still count),
+    // empty if every event opened
+    std::string missingEvents() const {
+        return threads_[0] ? threads_[0]->error() : "";
+    }
+
+    void start() {
+        for (auto& t : threads_) {
+            if (t) t->start();
+        }
+    }
+
+    void stop() {
+        for (auto& t : threads_) {
+            if (t) t->stop();
+        }
+    }
+
+    std::vector<CounterValues> perThread() const {
+        std::vector<CounterValues> values(threads_.size());
+        for (size_t i = 0; i < threads_.size(); i++) {
+            if (threads_[i]) values[i] = threads_[i]->read();
+        }
+        return values;
+    }
+
+    static CounterValues total(const std::vector<CounterValues>& perThread) {
+        CounterValues sum;
+        for (size_t i = 0; i < perThread.size(); i++) sum.accumulate(perThread[i], i == 0);
+        return sum;
+    }
+
+private:
+    std::vector<std::unique_ptr<ThreadCounters>> threads_;
+};
+
+#endif
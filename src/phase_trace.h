@@ -0,0 +1,212 @@
+#ifndef PHASE_TRACE_H
+#define PHASE_TRACE_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include <mpi.h>
+#include "distributed_graph.h"
+
+// Per-rank timeline of the exchange rounds in runExchangeRounds: when each
+// phase of each round started and ended on this rank. Recording costs two
+// MPI_Wtime calls and a push_back per phase, a few per round, so it can
+// stay on at scale; without a trace the rounds skip it entirely.
+enum class TracePhase {
+    PackSends,          // sort the outbox into per-neighbor blocks, start the exchange
+    Traverse,           // DFS over last round's arrivals, overlapping the exchange
+    WaitExchange,       // MPI_Wait on the neighborhood exchange
+    QueueReceived,      // received vertices to pending, overlapping the check
+    WaitTermination,    // MPI_Wait on the termination allreduce
+    Overflow,           // the ids that did not fit in the blocks, if any
+    Observer,           // the caller's per-round observer
+    Checkpoint          // copying the state for the checkpoint writer, if one is due
+};
+
+const int NUM_TRACE_PHASES = 8;
+
+inline const char* tracePhaseName(TracePhase phase) {
+    static const char* names[NUM_TRACE_PHASES] = {
+        "pack_sends", "traverse", "wait_exchange", "queue_received", "wait_termination",
+        "overflow", "observer", "checkpoint"};
+    return names[(int)phase];
+}
+
+struct TraceEvent {
+    TracePhase phase;
+    int round;
+    double start;       // seconds since the trace origin
+    double end;
+    int count;          // vertices traversed, sent or received; 0 otherwise
+};
+
+class PhaseTrace {
+public:
+    // Times are relative to construction. MPI clocks are not synchronized,
+    // so construct it on every rank right after a barrier for the ranks'
+    // timelines to line up.
+    explicit PhaseTrace(size_t expectedEvents = 4096) : origin_(MPI_Wtime()) {
+        events_.reserve(expectedEvents);
+    }
+
+    void record(TracePhase phase, int round, double start, double end, int count = 0) {
+        events_.push_back({phase, round, start - origin_, end - origin_, count});
+    }
+
+    const std::vector<TraceEvent>& events() const { return events_; }
+
+private:
+    double origin_;
+    std::vector<TraceEvent> events_;
+};
+
+// The phase hooks of runExchangeRounds; no-ops without a trace
+inline double phaseStart(PhaseTrace* trace) {
+    return trace ? MPI_Wtime() : 0.0;
+}
+
+inline void phaseEnd(PhaseTrace* trace, TracePhase phase, int round, double start, int count = 0) {
+    if (trace) trace->record(phase, round, start, MPI_Wtime(), count);
+}
+
+// Where one rank's time went
+struct PhaseSummary {
+    double phase[NUM_TRACE_PHASES] = {};
+    double span = 0;    // first phase start to last phase end
+
+    double waiting() const {
+        return phase[(int)TracePhase::WaitExchange] + phase[(int)TracePhase::Overflow];
+    }
+
+    // Share of the exchange window spent traversing rather than blocked in
+    // the exchange (the overflow exchange is never overlapped): 1 means
+    // the messages always arrived before the traversal ran out of work, 0
+    // that nothing overlapped them. The termination wait is left out since
+    // every rank blocks there for the slowest one; it shows up in the
+    // imbalance instead.
+    double overlapEfficiency() const {
+        double traverse = phase[(int)TracePhase::Traverse];
+        return traverse + waiting() > 0 ? traverse / (traverse + waiting()) : 1.0;
+    }
+};
+
+inline PhaseSummary summarizeTrace(const PhaseTrace& trace) {
+    PhaseSummary summary;
+    const std::vector<TraceEvent>& events = trace.events();
+    if (events.empty()) return summary;
+    double first = events.front().start, last = events.front().end;
+    for (const TraceEvent& e : events) {
+        summary.phase[(int)e.phase] += e.end - e.start;
+        first = std::min(first, e.start);
+        last = std::max(last, e.end);
+    }
+    summary.span = last - first;
+    return summary;
+}
+
+// Every rank's summary, on rank 0 (empty elsewhere). Collective.
+inline std::vector<PhaseSummary> gatherPhaseSummaries(const PhaseTrace& trace, const DomainInfo& domain) {
+    PhaseSummary local = summarizeTrace(trace);
+    const int width = NUM_TRACE_PHASES + 1;
+    double packed[width];
+    std::copy(local.phase, local.phase + NUM_TRACE_PHASES, packed);
+    packed[NUM_TRACE_PHASES] = local.span;
+
+    std::vector<double> all(domain.rank == 0 ? domain.numRanks * width : 0);
+    MPI_Gather(packed, width, MPI_DOUBLE, all.data(), width, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    std::vector<PhaseSummary> summaries;
+    if (domain.rank != 0) return summaries;
+    summaries.resize(domain.numRanks);
+    for (int r = 0; r < domain.numRanks; r++) {
+        std::copy(&all[r * width], &all[r * width] + NUM_TRACE_PHASES, summaries[r].phase);
+        summaries[r].span = all[r * width + NUM_TRACE_PHASES];
+    }
+    return summaries;
+}
+
+// Max over mean of one phase's time across ranks (1 = perfectly balanced)
+inline double phaseImbalance(const std::vector<PhaseSummary>& summaries, TracePhase phase) {
+    double sum = 0, most = 0;
+    for (const PhaseSummary& s : summaries) {
+        sum += s.phase[(int)phase];
+        most = std::max(most, s.phase[(int)phase]);
+    }
+    return sum > 0 ? most / (sum / summaries.size()) : 1.0;
+}
+
+// Per-rank table: time per phase, overlap efficiency, then the traversal
+// imbalance across ranks
+inline void printPhaseSummaries(std::ostream& out, const std::vector<PhaseSummary>& summaries) {
+    const TracePhase columns[] = {TracePhase::PackSends, TracePhase::Traverse, TracePhase::WaitExchange,
+                                  TracePhase::QueueReceived, TracePhase::WaitTermination,
+                                  TracePhase::Overflow};
+    out << "phase times (ms):" << std::endl;
+    out << std::left << std::setw(6) << "rank" << std::right;
+    for (TracePhase phase : columns) out << std::setw(17) << tracePhaseName(phase);
+    out << std::setw(10) << "span" << std::setw(9) << "overlap" << std::endl;
+    for (size_t r = 0; r < summaries.size(); r++) {
+        const PhaseSummary& s = summaries[r];
+        out << std::left << std::setw(6) << r << std::right << std::fixed << std::setprecision(3);
+        for (TracePhase phase : columns) out << std::setw(17) << s.phase[(int)phase] * 1000.0;
+        out << std::setw(10) << s.span * 1000.0
+            << std::setw(8) << std::setprecision(1) << s.overlapEfficiency() * 100.0 << "%" << std::endl;
+    }
+    out << "traversal imbalance (max/mean): " << std::setprecision(3)
+        << phaseImbalance(summaries, TracePhase::Traverse)
+        << ", termination wait imbalance: "
+        << phaseImbalance(summaries, TracePhase::WaitTermination) << std::endl;
+}
+
+// Every rank's events, on rank 0 (empty elsewhere). Collective.
+inline std::vector<std::vector<TraceEvent>> gatherTraceEvents(const PhaseTrace& trace,
+                                                              const DomainInfo& domain) {
+    const int width = 5;
+    std::vector<double> packed;
+    packed.reserve(trace.events().size() * width);
+    for (const TraceEvent& e : trace.events()) {
+        packed.insert(packed.end(), {(double)(int)e.phase, (double)e.round, e.start, e.end, (double)e.count});
+    }
+    int count = packed.size();
+    std::vector<int> counts(domain.numRanks, 0);
+    MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    std::vector<int> offsets(domain.numRanks, 0);
+    for (int r = 1; r < domain.numRanks; r++) offsets[r] = offsets[r - 1] + counts[r - 1];
+    std::vector<double> all(domain.rank == 0 ? offsets.back() + counts.back() : 0);
+    MPI_Gatherv(packed.data(), count, MPI_DOUBLE, all.data(), counts.data(), offsets.data(),
+                MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    std::vector<std::vector<TraceEvent>> events;
+    if (domain.rank != 0) return events;
+    events.resize(domain.numRanks);
+    for (int r = 0; r < domain.numRanks; r++) {
+        for (int i = offsets[r]; i < offsets[r] + counts[r]; i += width) {
+            events[r].push_back({(TracePhase)(int)all[i], (int)all[i + 1], all[i + 2], all[i + 3],
+                                 (int)all[i + 4]});
+        }
+    }
+    return events;
+}
+
+// Chrome trace event format (chrome://tracing, Perfetto): one process per
+// rank, one complete event per phase, times in microseconds
+inline void writeChromeTrace(std::ostream& out, const std::vector<std::vector<TraceEvent>>& events) {
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::fixed << std::setprecision(3);
+    bool first = true;
+    for (size_t r = 0; r < events.size(); r++) {
+        out << (first ? "\n" : ",\n")
+            << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << r
+            << ", \"args\": {\"name\": \"rank " << r << "\"}}";
+        first = false;
+        for (const TraceEvent& e : events[r]) {
+            out << ",\n  {\"name\": \"" << tracePhaseName(e.phase) << "\", \"ph\": \"X\", \"pid\": " << r
+                << ", \"tid\": 0, \"ts\": " << e.start * 1e6 << ", \"dur\": " << (e.end - e.start) * 1e6
+                << ", \"args\": {\"round\": " << e.round << ", \"count\": " << e.count << "}}";
+        }
+    }
+    out << "\n]}\n";
+}
+
+#endif
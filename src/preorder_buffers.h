@@ -0,0 +1,134 @@
+#ifndef PREORDER_BUFFERS_H
+#define PREORDER_BUFFERS_H
+
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+
+struct PreorderEntry {
+    int vertex;
+    int parent;     // -1 for a root
+};
+
+enum class MergeOrder {
+    ThreadOrder,    // concatenate thread 0, 1, ... buffers (cheapest)
+    VertexOrder     // ascending vertex id: reproducible across runs and
+                    // directly comparable with a sorted serial dfs()
+};
+
+// Result of merging the per-thread buffers. The tree arrays are sized to
+// the graph and hold -1 for vertices that were not visited; they are left
+// empty unless requested. (discoveryThread[v], discoveryIndex[v]) is the
+// thread that claimed v and its position in that thread's buffer, which
+// is a valid preorder timestamp along every tree path walked by one thread.
+struct MergedPreorder {
+    std::vector<int> order;
+    std::vector<int> parent;
+    std::vector<int> discoveryThread;
+    std::vector<int> discoveryIndex;
+};
+
+// One append-only buffer per worker thread, so visiting a vertex never
+// touches shared state; the single result vector is built afterwards.
+class ThreadLocalPreorder {
+public:
+    explicit ThreadLocalPreorder(int numThreads) : buffers_(numThreads < 1 ? 1 : numThreads) {}
+
+    void clear() {
+        for (Buffer& b : buffers_) b.entries.clear();
+    }
+
+    void append(int tid, int vertex, int parent) {
+        buffers_[tid].entries.push_back({vertex, parent});
+    }
+
+    const std::vector<PreorderEntry>& buffer(int tid) const { return buffers_[tid].entries; }
+    int numThreads() const { return buffers_.size(); }
+
+    size_t totalSize() const {
+        size_t total = 0;
+        for (const Buffer& b : buffers_) total += b.entries.size();
+        return total;
+    }
+
+    MergedPreorder merge(int numVertices, MergeOrder mergeOrder, bool withTree = false) const {
+        MergedPreorder result;
+        int numBuffers = buffers_.size();
+
+        if (withTree) {
+            result.parent.assign(numVertices, -1);
+            result.discoveryThread.assign(numVertices, -1);
+            result.discoveryIndex.assign(numVertices, -1);
+
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (int t = 0; t < numBuffers; t++) {
+                const std::vector<PreorderEntry>& entries = buffers_[t].entries;
+                for (int i = 0; i < (int)entries.size(); i++) {
+                    int v = entries[i].vertex;
+                    result.parent[v] = entries[i].parent;
+                    result.discoveryThread[v] = t;
+                    result.discoveryIndex[v] = i;
+                }
+            }
+        }
+
+        if (mergeOrder == MergeOrder::ThreadOrder) {
+            std::vector<size_t> start(numBuffers + 1, 0);
+            for (int t = 0; t < numBuffers; t++) {
+                start[t + 1] = start[t] + buffers_[t].entries.size();
+            }
+            result.order.resize(start[numBuffers]);
+
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (int t = 0; t < numBuffers; t++) {
+                const std::vector<PreorderEntry>& entries = buffers_[t].entries;
+                for (size_t i = 0; i < entries.size(); i++) {
+                    result.order[start[t] + i] = entries[i].vertex;
+                }
+            }
+            return result;
+        }
+
+        // VertexOrder: mark visited vertices, then compact the marks in
+        // parallel blocks whose output offsets come from a prefix sum.
+        std::vector<char> seen(numVertices, 0);
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int t = 0; t < numBuffers; t++) {
+            for (const PreorderEntry& e : buffers_[t].entries) seen[e.vertex] = 1;
+        }
+
+        const int BLOCK = 1 << 16;
+        int numBlocks = (numVertices + BLOCK - 1) / BLOCK;
+        std::vector<size_t> blockStart(numBlocks + 1, 0);
+
+        #pragma omp parallel for
+        for (int b = 0; b < numBlocks; b++) {
+            int end = std::min(numVertices, (b + 1) * BLOCK);
+            size_t count = 0;
+            for (int v = b * BLOCK; v < end; v++) count += seen[v];
+            blockStart[b + 1] = count;
+        }
+        for (int b = 0; b < numBlocks; b++) blockStart[b + 1] += blockStart[b];
+        result.order.resize(blockStart[numBlocks]);
+
+        #pragma omp parallel for
+        for (int b = 0; b < numBlocks; b++) {
+            int end = std::min(numVertices, (b + 1) * BLOCK);
+            size_t pos = blockStart[b];
+            for (int v = b * BLOCK; v < end; v++) {
+                if (seen[v]) result.order[pos++] = v;
+            }
+        }
+        return result;
+    }
+
+private:
+    // Padded so that two threads appending never share a cache line
+    struct alignas(64) Buffer {
+        std::vector<PreorderEntry> entries;
+    };
+
+    std::vector<Buffer> buffers_;
+};
+
+#endif
@@ -1,183 +1,165 @@
 #include <iostream>
 #include <vector>
 #include <omp.h>
-#include <chrono>
 #include <iomanip>
 #include <fstream>
-#include <cmath>
+#include <algorithm>
+#include "graph.h"
+#include "graph_io.h"
+#include "dfs_engine.h"
+#include "atomic_bitmap.h"
+#include "work_stealing_dfs.h"
+#include "preorder_buffers.h"
+#include "vertex_order.h"
+#include "bench_stats.h"
+#include "perf_counters.h"
 using namespace std;
 
-// Serial DFS implementation
-void dfsRecSerial(vector<vector<int>> &adj, vector<bool> &visited, int s, vector<int> &res) {
-    visited[s] = true;
-    res.push_back(s);
-
-    double work = 0;
-    for (int i = 0; i < 1000; i++)
-    {
-        work += (s * i) % 100;
-    }
-
-    for (int i : adj[s])
-        if (visited[i] == false)
-            dfsRecSerial(adj, visited, i, res);
-}
-
-vector<int> dfsSerial(vector<vector<int>> &adj) {
-    vector<bool> visited(adj.size(), false);
-    vector<int> res;
+// Serial DFS implementation. Reuses context's visited stamps, stack and result buffer on every call
+vector<int> &dfsSerial(const CSRGraph &adj, TraversalContext &context) {
+    context.begin(adj.size());
+    EpochVisited &visited = context.visited;
+    vector<int> &res = context.result;
 
     for (int i = 0; i < adj.size(); i++)
     {
-        if (visited[i] == false)
+        if (!visited.test(i))
         {
-            dfsRecSerial(adj, visited, i, res);
+            iterativeDFS(adj, visited, i, 1, context.stack,
+                         visitWith<SyntheticWork>(CollectVisit{res}));
         }
     }
     return res;
 }
 
-// Parallel DFS implementation
-void dfsRecParallel(vector<vector<int>> &adj, vector<bool> &visited, int s, vector<int> &res) {
-    #pragma omp critical
-    {
-        if (!visited[s])
-        {
-            visited[s] = true;
-            res.push_back(s);
-        }
-    }
-
-    double work = 0;
-    for (int i = 0; i < 1000; i++)
-    {
-        work += (s * i) % 100;
-    }
-
-    for (int i : adj[s])
-    {
-        bool needsVisit = false;
-
-        #pragma omp critical
-        {
-            needsVisit = !visited[i];
-        }
-
-        if (needsVisit) {
-            #pragma omp task shared(adj, visited, res)
-            {
-                dfsRecParallel(adj, visited, i, res);
-            }
-        }
-    }
-    #pragma omp taskwait
-}
-
-vector<int> dfsParallel(vector<vector<int>> &adj)
+// Parallel DFS implementation; visited and buffers are the caller's, reused across runs
+vector<int> dfsParallel(const CSRGraph &adj, WorkStealingDFS &engine, AtomicBitmap &visited,
+                        ThreadLocalPreorder &buffers, MergeOrder order = MergeOrder::ThreadOrder)
 {
-    vector<bool> visited(adj.size(), false);
-    vector<int> res;
+    visited.clear();
+    buffers.clear();
+
+    engine.run(adj, visited, 1, [&](int s, int parent, int tid) {
+        buffers.append(tid, s, parent);
+        syntheticWork(s);
+    });
+    return buffers.merge(adj.size(), order).order;
+}
 
-    #pragma omp parallel
-    {
-        #pragma omp single
-        {
-            for (int i = 0; i < adj.size(); i++)
-            {
-                if (visited[i] == false)
-                {
-                    dfsRecParallel(adj, visited, i, res);
-                }
-            }
-        }
-    }
-    return res;
+// Median serial time; the warmup runs are timed but discarded. counts gets
+// the per-run hardware counters of the timed runs, or stays empty if they
+// cannot be opened
+RunStats measureSerialTime(const CSRGraph &adj, vector<CounterValues> &counts,
+                           int iterations = 5, int warmup = 1) {
+    TraversalContext context(adj.size());
+    auto run = [&]() { dfsSerial(adj, context); };
+    PerfCounters counters(1);
+    counts.clear();
+    vector<double> times = counters.available()
+        ? timeRunsCounted(warmup, iterations, run, counters, counts)
+        : timeRuns(warmup, iterations, run);
+    return summarizeRuns(times, warmup);
 }
 
-// Create test graph
-vector<vector<int>> createGraph(int numVertices) {
-    vector<vector<int>> adj(numVertices);
+// Same for the parallel version with the specified number of threads,
+// counted on each worker thread
+RunStats measureParallelTime(const CSRGraph &adj, int numThreads, vector<CounterValues> &counts,
+                             int iterations = 5, int warmup = 1) {
+    WorkStealingDFS engine(numThreads);
+    AtomicBitmap visited(adj.size());
+    ThreadLocalPreorder buffers(engine.numThreads());
+    auto run = [&]() { dfsParallel(adj, engine, visited, buffers); };
+    PerfCounters counters(engine.numThreads());
+    counts.clear();
+    vector<double> times = counters.available()
+        ? timeRunsCounted(warmup, iterations, run, counters, counts)
+        : timeRuns(warmup, iterations, run);
+    return summarizeRuns(times, warmup);
+}
 
-    for (int i = 0; i < numVertices; i++)
-    {
-        int connections = 2 + (i % 3);
-        for (int j = 1; j <= connections; j++)
-        {
-            int neighbor = (i * 7 + j * 13) % numVertices;
-            if (neighbor != i)
-            {
-                adj[i].push_back(neighbor);
-            }
+// Per-run counters of each thread and their total; "-" marks an event the
+// machine did not provide
+void printCounters(const vector<CounterValues> &counts) {
+    if (counts.empty()) return;
+    const int columns[] = {CNT_CYCLES, CNT_INSTRUCTIONS, CNT_L1D_MISSES, CNT_LLC_MISSES,
+                           CNT_DTLB_MISSES, CNT_BRANCH_MISSES, CNT_TASK_CLOCK};
+    auto printRow = [&](const string &label, const CounterValues &values) {
+        cout << left << setw(8) << label << right;
+        for (int id : columns) {
+            if (values.valid[id]) cout << setw(14) << fixed << setprecision(0) << values.value[id];
+            else cout << setw(14) << "-";
         }
-    }
-    return adj;
+        if (values.ipc() > 0) cout << setw(7) << fixed << setprecision(2) << values.ipc();
+        else cout << setw(7) << "-";
+        cout << endl;
+    };
+    cout << left << setw(8) << "thread" << right;
+    for (int id : columns) cout << setw(14) << counterName(id);
+    cout << setw(7) << "ipc" << endl;
+    for (size_t t = 0; t < counts.size(); t++) printRow(to_string(t), counts[t]);
+    if (counts.size() > 1) printRow("total", PerfCounters::total(counts));
 }
 
-// Measure execution time for serial version
-double measureSerialTime(vector<vector<int>> &adj, int iterations = 5) {
-    vector<double> times;
-    
-    for (int iter = 0; iter < iterations; iter++) {
-        auto start = chrono::high_resolution_clock::now();
-        vector<int> result = dfsSerial(adj);
-        auto end = chrono::high_resolution_clock::now();
-        
-        chrono::duration<double> duration = end - start;
-        times.push_back(duration.count());
-    }
+int main()
+{
+    int numVertices = 50000;
+    const int iterations = 5; // Timed runs per measurement
+    const int warmup = 1;     // Untimed runs before them
     
-    // Calculate average (excluding first warmup run if needed)
-    double sum = 0;
-    for (double t : times) {
-        sum += t;
+    // Load or create the graph once
+    CSRGraph adj;
+    const char* graphFile = graphFileFromEnv();
+    if (graphFile) {
+        string error;
+        if (!mapGraphFile(graphFile, adj, error)) {
+            cerr << error << endl;
+            return 1;
+        }
+        numVertices = adj.size();
+    } else {
+        adj = createTestGraph(numVertices);
     }
-    return sum / times.size();
-}
 
-// Measure execution time for parallel version with specified threads
-double measureParallelTime(vector<vector<int>> &adj, int numThreads, int iterations = 5) {
-    omp_set_num_threads(numThreads);
-    vector<double> times;
-    
-    for (int iter = 0; iter < iterations; iter++) {
-        auto start = chrono::high_resolution_clock::now();
-        vector<int> result = dfsParallel(adj);
-        auto end = chrono::high_resolution_clock::now();
-        
-        chrono::duration<double> duration = end - start;
-        times.push_back(duration.count());
+    // Both traversals run on the relabeled graph, so their results still compare
+    VertexOrdering ordering;
+    if (!vertexOrderingFromEnv(ordering)) {
+        cerr << "unknown VERTEX_ORDER (use original, bfs, rcm or degree)" << endl;
+        return 1;
     }
-    
-    // Calculate average
-    double sum = 0;
-    for (double t : times) {
-        sum += t;
+    if (ordering != VertexOrdering::Original) {
+        adj = relabelGraph(adj, VertexPermutation(computeVertexOrder(adj, ordering)));
     }
-    return sum / times.size();
-}
-
-int main()
-{
-    const int numVertices = 50000;
-    const int iterations = 5; // Number of runs for averaging
     
     cout << "===========================================" << endl;
     cout << "Performance Profiling: DFS Traversal" << endl;
     cout << "===========================================" << endl;
     cout << "Graph size: " << numVertices << " vertices" << endl;
-    cout << "Averaging over " << iterations << " iterations" << endl;
+    if (graphFile) {
+        cout << "Graph file: " << graphFile << endl;
+    }
+    cout << "Vertex order: " << vertexOrderingName(ordering) << endl;
+    cout << "Median of " << iterations << " iterations after " << warmup << " warmup run" << endl;
+    PerfCounters probe(1);
+    if (!probe.available()) {
+        cout << "Hardware counters: unavailable (" << probe.unavailableReason() << ")" << endl;
+    } else if (!probe.missingEvents().empty()) {
+        cout << "Hardware counters: per run, some events missing (" << probe.missingEvents() << ")" << endl;
+    } else {
+        cout << "Hardware counters: per run, via perf_event_open" << endl;
+    }
     cout << "===========================================" << endl << endl;
     
-    // Create graph once
-    cout << "Creating graph..." << endl;
-    vector<vector<int>> adj = createGraph(numVertices);
-    cout << "Graph created successfully!" << endl << endl;
-    
     // Measure serial time (T_S)
     cout << "Measuring Serial Execution Time (T_S)..." << endl;
-    double T_S = measureSerialTime(adj, iterations);
+    vector<CounterValues> serialCounts;
+    RunStats serialStats = measureSerialTime(adj, serialCounts, iterations, warmup);
+    double T_S = serialStats.median;
     cout << "T_S = " << fixed << setprecision(6) << T_S << " seconds" << endl;
-    cout << "T_S = " << fixed << setprecision(3) << (T_S * 1000.0) << " milliseconds" << endl << endl;
+    cout << "T_S = " << fixed << setprecision(3) << (T_S * 1000.0) << " milliseconds"
+         << " (p95 " << serialStats.p95 * 1000.0 << " ms, stddev " << serialStats.stddev * 1000.0
+         << " ms)" << endl;
+    printCounters(serialCounts);
+    cout << endl;
     
     // Measure parallel times for different thread counts
     vector<int> threadCounts = {1, 2, 4, 8};
@@ -190,7 +172,9 @@ int main()
     
     for (int threads : threadCounts) {
         cout << "\nTesting with " << threads << " thread(s)..." << endl;
-        double T_P = measureParallelTime(adj, threads, iterations);
+        vector<CounterValues> parallelCounts;
+        RunStats parallelStats = measureParallelTime(adj, threads, parallelCounts, iterations, warmup);
+        double T_P = parallelStats.median;
         T_P_values.push_back(T_P);
         
         double speedup = T_S / T_P;
@@ -200,9 +184,12 @@ int main()
         efficiencies.push_back(efficiency);
         
         cout << "T_P(" << threads << ") = " << fixed << setprecision(6) << T_P << " seconds" << endl;
-        cout << "T_P(" << threads << ") = " << fixed << setprecision(3) << (T_P * 1000.0) << " milliseconds" << endl;
+        cout << "T_P(" << threads << ") = " << fixed << setprecision(3) << (T_P * 1000.0) << " milliseconds"
+             << " (p95 " << parallelStats.p95 * 1000.0 << " ms, stddev "
+             << parallelStats.stddev * 1000.0 << " ms)" << endl;
         cout << "Speedup (S) = " << fixed << setprecision(4) << speedup << endl;
         cout << "Efficiency (E) = " << fixed << setprecision(4) << efficiency << " (" << (efficiency * 100) << "%)" << endl;
+        printCounters(parallelCounts);
     }
     
     // Output summary table
@@ -224,13 +211,25 @@ int main()
     
     cout << "\nSerial Time (T_S): " << fixed << setprecision(6) << T_S << " seconds" << endl;
     
+    // Check that the parallel traversal visits exactly the serial vertex set
+    TraversalContext checkContext(adj.size());
+    vector<int> &serialSorted = dfsSerial(adj, checkContext);
+    sort(serialSorted.begin(), serialSorted.end());
+    WorkStealingDFS checkEngine(threadCounts.back());
+    AtomicBitmap checkVisited(adj.size());
+    ThreadLocalPreorder checkBuffers(checkEngine.numThreads());
+    bool matches = dfsParallel(adj, checkEngine, checkVisited, checkBuffers,
+                               MergeOrder::VertexOrder) == serialSorted;
+    cout << "Parallel result matches serial: " << (matches ? "yes" : "NO") << endl;
+    
     // Save results to file
     ofstream resultsFile("performance_results.txt");
     if (resultsFile.is_open()) {
         resultsFile << "Performance Profiling Results\n";
         resultsFile << "============================\n\n";
         resultsFile << "Graph size: " << numVertices << " vertices\n";
-        resultsFile << "Iterations per measurement: " << iterations << "\n\n";
+        resultsFile << "Iterations per measurement: " << iterations << " (median, after "
+                    << warmup << " warmup run)\n\n";
         resultsFile << "Serial Time (T_S): " << fixed << setprecision(6) << T_S << " seconds\n\n";
         resultsFile << left << setw(10) << "Threads" 
                     << setw(15) << "T_P (seconds)" 
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <string>
+#include <cstdlib>
+#include "graph.h"
+#include "reachability_index.h"
+using namespace std;
+
+// Randomized check of ReachabilityIndex: builds the index for small random
+// directed graphs and compares every (source, target) answer with a plain
+// DFS from the source.
+//
+//   reachability_check [trials] [seed]
+//
+// The graphs are clusters of dense random edges (nontrivial strongly
+// connected components) joined by sparse edges in both directions, so the
+// condensed DAG has cross edges the tree intervals miss and queries that
+// need the low/post pruning and the fallback search.
+
+// A random graph: vertices split into clusters, a denser edge set inside
+// each cluster, sparse edges between any two vertices
+static vector<vector<int>> randomGraph(mt19937& rng) {
+    int n = 1 + rng() % 120;
+    int clusterSize = 1 + rng() % 8;
+    int inside = rng() % 4;
+    int across = rng() % 3;
+    vector<vector<int>> lists(n);
+    for (int v = 0; v < n; v++) {
+        int first = v / clusterSize * clusterSize;
+        int size = min(clusterSize, n - first);
+        for (int j = rng() % (inside + 1); j > 0; j--) lists[v].push_back(first + rng() % size);
+        if (rng() % 3 < across) lists[v].push_back(rng() % n);
+    }
+    return lists;
+}
+
+int main(int argc, char** argv) {
+    int trials = argc > 1 ? atoi(argv[1]) : 500;
+    unsigned seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+    mt19937 rng(seed);
+    long long queries = 0;
+    long long fallbacks = 0;
+    for (int t = 0; t < trials; t++) {
+        vector<vector<int>> lists = randomGraph(rng);
+        int n = lists.size();
+        CSRGraph graph = buildGraph(n, [&](int v, auto&& emit) {
+            for (int u : lists[v]) emit(u);
+        });
+        ReachabilityIndex index(graph);
+
+        // reach[s][v]: plain DFS from every source
+        vector<vector<char>> reach(n, vector<char>(n, 0));
+        for (int s = 0; s < n; s++) {
+            vector<int> stack = {s};
+            reach[s][s] = 1;
+            while (!stack.empty()) {
+                int v = stack.back();
+                stack.pop_back();
+                for (int u : graph[v]) {
+                    if (reach[s][u]) continue;
+                    reach[s][u] = 1;
+                    stack.push_back(u);
+                }
+            }
+        }
+
+        for (int s = 0; s < n; s++) {
+            for (int v = 0; v < n; v++) {
+                bool sameComponent = reach[s][v] && reach[v][s];
+                if ((index.component(s) == index.component(v)) != sameComponent) {
+                    cerr << "reachability_check: trial " << t << " (seed " << seed << "): vertices " << s
+                         << " and " << v << (sameComponent ? " should" : " should not")
+                         << " share a component" << endl;
+                    return 1;
+                }
+                if (index.reachable(s, v) != (bool)reach[s][v]) {
+                    cerr << "reachability_check: trial " << t << " (seed " << seed << "): reachable(" << s
+                         << ", " << v << ") is " << !reach[s][v] << ", DFS says " << (int)reach[s][v] << endl;
+                    return 1;
+                }
+                queries++;
+            }
+        }
+        fallbacks += index.fallbackQueries();
+    }
+    cout << "reachability_check: " << trials << " trials ok (" << queries << " queries, " << fallbacks
+         << " needed the DAG search)" << endl;
+    return 0;
+}
@@ -0,0 +1,200 @@
+#ifndef REACHABILITY_INDEX_H
+#define REACHABILITY_INDEX_H
+
+#include <vector>
+#include <algorithm>
+#include "graph.h"
+#include "dfs_engine.h"
+
+// Precomputed reachability for a directed graph, built once per loaded
+// graph. Vertices are collapsed into strongly connected components (for a
+// symmetric graph these are the connected components) and queries run on
+// the condensed DAG, mostly answered from labels alone:
+//
+// - component[v] comes from Tarjan, which finishes a component only after
+//   every component it reaches, so an edge a -> b between components
+//   implies component[a] > component[b].
+// - pre / post are the entry and exit times of a DFS spanning forest of
+//   the DAG: b inside a's tree interval means a reaches b.
+// - low[c] is the smallest post time reachable from c. Everything a
+//   reaches has its post time in [low[a], post[a]], so a b outside that
+//   range is unreachable.
+//
+// Only the queries that neither label settles fall back to a DFS over the
+// DAG, pruned with the same interval test.
+class ReachabilityIndex {
+public:
+    ReachabilityIndex() = default;
+
+    explicit ReachabilityIndex(const CSRGraph& adj) {
+        computeComponents(adj);
+        buildCondensedGraph(adj);
+        computeLabels();
+    }
+
+    int numComponents() const { return numComponents_; }
+    int component(int v) const { return component_[v]; }
+    int numVertices() const { return component_.size(); }
+
+    // Is target reachable from source? Not thread-safe (the fallback DFS
+    // uses shared scratch space).
+    bool reachable(int source, int target) const {
+        int a = component_[source];
+        int b = component_[target];
+        if (a == b) return true;
+        if (a < b || !mayReach(a, b)) return false;
+        if (pre_[a] <= pre_[b] && post_[b] <= post_[a]) return true;
+
+        fallbackQueries_++;
+        if (mark_.size() != (size_t)numComponents_) mark_.assign(numComponents_, 0);
+        if (++epoch_ == 0) {
+            std::fill(mark_.begin(), mark_.end(), 0);
+            epoch_ = 1;
+        }
+        stack_.clear();
+        stack_.push_back(a);
+        mark_[a] = epoch_;
+        while (!stack_.empty()) {
+            int c = stack_.back();
+            stack_.pop_back();
+            for (int d : dag_[c]) {
+                if (d == b) return true;
+                if (mark_[d] == epoch_ || d < b || !mayReach(d, b)) continue;
+                mark_[d] = epoch_;
+                stack_.push_back(d);
+            }
+        }
+        return false;
+    }
+
+    // Queries that needed the DAG search, for checking how well the labels work
+    long long fallbackQueries() const { return fallbackQueries_; }
+
+private:
+    bool mayReach(int a, int b) const {
+        return low_[a] <= post_[b] && post_[b] <= post_[a];
+    }
+
+    // Iterative Tarjan: frames hold the vertex and its next edge
+    void computeComponents(const CSRGraph& adj) {
+        int n = adj.size();
+        std::vector<int> index(n, -1);
+        std::vector<int> lowlink(n, 0);
+        std::vector<char> onStack(n, 0);
+        std::vector<int> sccStack;
+        std::vector<DFSFrame> frames;
+        component_.assign(n, -1);
+        numComponents_ = 0;
+        int nextIndex = 0;
+
+        auto open = [&](int v) {
+            index[v] = lowlink[v] = nextIndex++;
+            sccStack.push_back(v);
+            onStack[v] = 1;
+            frames.push_back({v, 0});
+        };
+
+        for (int root = 0; root < n; root++) {
+            if (index[root] != -1) continue;
+            open(root);
+            while (!frames.empty()) {
+                DFSFrame& top = frames.back();
+                int v = top.vertex;
+                if (top.next < adj.degree(v)) {
+                    int u = adj[v][top.next++];
+                    if (index[u] == -1) {
+                        open(u);
+                    } else if (onStack[u]) {
+                        lowlink[v] = std::min(lowlink[v], index[u]);
+                    }
+                    continue;
+                }
+                frames.pop_back();
+                if (!frames.empty()) {
+                    int parent = frames.back().vertex;
+                    lowlink[parent] = std::min(lowlink[parent], lowlink[v]);
+                }
+                if (lowlink[v] == index[v]) {
+                    int u;
+                    do {
+                        u = sccStack.back();
+                        sccStack.pop_back();
+                        onStack[u] = 0;
+                        component_[u] = numComponents_;
+                    } while (u != v);
+                    numComponents_++;
+                }
+            }
+        }
+    }
+
+    void buildCondensedGraph(const CSRGraph& adj) {
+        // Members of each component, grouped by a counting sort
+        std::vector<int> start(numComponents_ + 1, 0);
+        for (int c : component_) start[c + 1]++;
+        for (int c = 0; c < numComponents_; c++) start[c + 1] += start[c];
+        std::vector<int> members(component_.size());
+        std::vector<int> fill(start.begin(), start.end() - 1);
+        for (int v = 0; v < (int)component_.size(); v++) members[fill[component_[v]]++] = v;
+
+        dag_ = buildGraph(numComponents_, [&](int c, auto&& emit) {
+            std::vector<int> targets;
+            for (int i = start[c]; i < start[c + 1]; i++) {
+                for (int u : adj[members[i]]) {
+                    if (component_[u] != c) targets.push_back(component_[u]);
+                }
+            }
+            std::sort(targets.begin(), targets.end());
+            targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+            for (int d : targets) emit(d);
+        });
+    }
+
+    void computeLabels() {
+        pre_.assign(numComponents_, -1);
+        post_.assign(numComponents_, -1);
+        int clock = 0;
+        std::vector<DFSFrame> frames;
+        // High ids have no incoming edges from lower ones, so start there
+        for (int root = numComponents_ - 1; root >= 0; root--) {
+            if (pre_[root] != -1) continue;
+            pre_[root] = clock++;
+            frames.push_back({root, 0});
+            while (!frames.empty()) {
+                DFSFrame& top = frames.back();
+                int c = top.vertex;
+                if (top.next < dag_.degree(c)) {
+                    int d = dag_[c][top.next++];
+                    if (pre_[d] == -1) {
+                        pre_[d] = clock++;
+                        frames.push_back({d, 0});
+                    }
+                    continue;
+                }
+                post_[c] = clock++;
+                frames.pop_back();
+            }
+        }
+
+        // Successors have smaller ids, so ascending order sees them first
+        low_.assign(numComponents_, 0);
+        for (int c = 0; c < numComponents_; c++) {
+            low_[c] = post_[c];
+            for (int d : dag_[c]) low_[c] = std::min(low_[c], low_[d]);
+        }
+    }
+
+    std::vector<int> component_;
+    int numComponents_ = 0;
+    CSRGraph dag_;
+    std::vector<int> pre_;
+    std::vector<int> post_;
+    std::vector<int> low_;
+
+    mutable std::vector<int> mark_;
+    mutable std::vector<int> stack_;
+    mutable int epoch_ = 0;
+    mutable long long fallbackQueries_ = 0;
+};
+
+#endif
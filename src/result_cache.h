@@ -0,0 +1,67 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <list>
+#include <map>
+#include <tuple>
+#include <utility>
+
+// Key of a cached traversal: which resident graph (bumped whenever the
+// graph is rebuilt), the source, the target and the traversal mode (the
+// modes agree on found but may stop after different visited counts)
+typedef std::tuple<long long, int, int, int> QueryKey;
+
+// Least-recently-used cache of recent traversal results
+template <typename Value>
+class ResultCache {
+public:
+    explicit ResultCache(size_t capacity = 1024) : capacity_(capacity) {}
+
+    // Returns nullptr on a miss; a hit becomes the most recent entry
+    const Value* find(const QueryKey& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            misses_++;
+            return nullptr;
+        }
+        entries_.splice(entries_.begin(), entries_, it->second);
+        hits_++;
+        return &it->second->second;
+    }
+
+    void insert(const QueryKey& key, const Value& value) {
+        if (capacity_ == 0) return;
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            it->second->second = value;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return;
+        }
+        if (entries_.size() == capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+        entries_.emplace_front(key, value);
+        index_[key] = entries_.begin();
+    }
+
+    void clear() {
+        entries_.clear();
+        index_.clear();
+    }
+
+    size_t size() const { return entries_.size(); }
+    long long hits() const { return hits_; }
+    long long misses() const { return misses_; }
+
+private:
+    typedef std::list<std::pair<QueryKey, Value>> EntryList;
+
+    size_t capacity_;
+    EntryList entries_;     // most recent first
+    std::map<QueryKey, typename EntryList::iterator> index_;
+    long long hits_ = 0;
+    long long misses_ = 0;
+};
+
+#endif
@@ -1,54 +1,43 @@
 #include <iostream>
 #include <vector>
-#include <ctime>
+#include <chrono>
+#include "graph.h"
+#include "graph_io.h"
+#include "dfs_engine.h"
+#include "vertex_order.h"
 using namespace std;
 
 bool targetFound = false;
 int targetVertex = 1;  // Changed from 42000 to 1 (guaranteed to exist)
+int targetLabel = targetVertex;  // targetVertex's id in the relabeled graph
 
-void dfsRec(vector<vector<int>> &adj, vector<bool> &visited, int s, vector<int> &res, int stride) {
-    visited[s] = true;
+void visitVertex(int s, vector<int> &res) {
     res.push_back(s);
 
     // Check if this is the target vertex
-    if (s == targetVertex) {
+    if (s == targetLabel) {
         targetFound = true;
         cout << "found target: vertex " << targetVertex << endl;
     }
 
-    double work = 0;
-    for (int i = 0; i < 1000; i++)
-    {
-        work += (s * i) % 100;
-    }
-
-    for (int idx = 0; idx < adj[s].size(); idx += stride)
-    {
-        int i = adj[s][idx];
-        if (visited[i] == false)
-            dfsRec(adj, visited, i, res, stride);
-    }
-    
-    for (int idx = 0; idx < adj[s].size(); idx++)
-    {
-        if (idx % stride != 0)
-        {
-            int i = adj[s][idx];
-            if (visited[i] == false)
-                dfsRec(adj, visited, i, res, stride);
-        }
-    }
+    syntheticWork(s);
 }
 
-vector<int> dfs(vector<vector<int>> &adj, int stride) {
-    vector<bool> visited(adj.size(), false);
-    vector<int> res;
+// Runs in context, whose buffers are reused by every call; the returned
+// result is context.result
+vector<int> &dfs(const CSRGraph &adj, int stride, TraversalContext &context) {
+    context.begin(adj.size());
+    EpochVisited &visited = context.visited;
+    vector<int> &res = context.result;
 
     for (int i = 0; i < adj.size(); i++)
     {
-        if (visited[i] == false)
+        if (!visited.test(i))
         {
-            dfsRec(adj, visited, i, res, stride);
+            iterativeDFS(adj, visited, i, stride, context.stack, [&](int s) {
+                visitVertex(s, res);
+                return false;
+            });
         }
     }
     return res;
@@ -57,25 +46,38 @@ vector<int> dfs(vector<vector<int>> &adj, int stride) {
 int main()
 {
     int numVertices = 50000;
-    vector<vector<int>> adj(numVertices);
-
-    cout << "Creating large graph with " << numVertices << " vertices..." << endl;
 
-    for (int i = 0; i < numVertices; i++)
-    {
-        int connections = 2 + (i % 3);
-        for (int j = 1; j <= connections; j++)
-        {
-            int neighbor = (i * 7 + j * 13) % numVertices;
-            if (neighbor != i)
-            {
-                adj[i].push_back(neighbor);
-            }
+    CSRGraph adj;
+    if (const char* graphFile = graphFileFromEnv()) {
+        string error;
+        if (!mapGraphFile(graphFile, adj, error)) {
+            cerr << error << endl;
+            return 1;
         }
+        numVertices = adj.size();
+        cout << "Mapped graph file " << graphFile << " (" << numVertices << " vertices, "
+             << adj.numEdges() << " edges)" << endl;
+    } else {
+        cout << "Creating large graph with " << numVertices << " vertices..." << endl;
+        adj = createTestGraph(numVertices);
+    }
+
+    VertexOrdering ordering;
+    if (!vertexOrderingFromEnv(ordering)) {
+        cerr << "unknown VERTEX_ORDER (use original, bfs, rcm or degree)" << endl;
+        return 1;
+    }
+    VertexPermutation perm;
+    if (ordering != VertexOrdering::Original) {
+        perm = VertexPermutation(computeVertexOrder(adj, ordering));
+        adj = relabelGraph(adj, perm);
+        targetLabel = perm.newId[targetVertex];
+        cout << "Relabeled vertices in " << vertexOrderingName(ordering) << " order" << endl;
     }
 
     cout << "Graph created successfully!" << endl;
 
+    TraversalContext context(adj.size());
     int strides[] = {1, 2, 4, 8, 16};
     int num_strides = sizeof(strides) / sizeof(strides[0]);
 
@@ -85,15 +87,19 @@ int main()
         cout << "DFS Traversal of the graph (Serial):" << endl;
         cout << "Stride size: " << stride << endl;
 
-        clock_t start = clock();
+        // Wall time, like parallel.cpp (clock() would count CPU time)
+        auto start = chrono::steady_clock::now();
 
-        vector<int> result = dfs(adj, stride);
+        vector<int> &result = dfs(adj, stride, context);
 
-        clock_t end = clock();
+        auto end = chrono::steady_clock::now();
 
-        double time_seconds = double(end - start) / CLOCKS_PER_SEC;
+        double time_seconds = chrono::duration<double>(end - start).count();
         double time_ms = time_seconds * 1000.0;
 
+        // Report original vertex IDs
+        perm.toOriginal(result);
+
         cout << "Total vertices visited: " << result.size() << endl;
         cout << "First 10 vertices: ";
         for (int i = 0; i < 10 && i < result.size(); i++)
@@ -0,0 +1,144 @@
+#ifndef VERTEX_ORDER_H
+#define VERTEX_ORDER_H
+
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include "graph.h"
+
+// Relabeling applied before traversal (or partitioning) so that vertices
+// visited close together also sit close together in offsets, neighbors
+// and visited.
+enum class VertexOrdering {
+    Original,
+    BFS,        // breadth-first order over the symmetrized graph
+    RCM,        // reverse Cuthill-McKee: BFS from a low-degree vertex, neighbors
+                // by increasing degree, reversed; keeps edges near the diagonal
+    Degree      // decreasing degree: hub rows share the first cache lines
+};
+
+inline bool parseVertexOrdering(const std::string& name, VertexOrdering& ordering) {
+    if (name == "original" || name == "none") {
+        ordering = VertexOrdering::Original;
+    } else if (name == "bfs") {
+        ordering = VertexOrdering::BFS;
+    } else if (name == "rcm") {
+        ordering = VertexOrdering::RCM;
+    } else if (name == "degree") {
+        ordering = VertexOrdering::Degree;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline const char* vertexOrderingName(VertexOrdering ordering) {
+    switch (ordering) {
+    case VertexOrdering::BFS: return "bfs";
+    case VertexOrdering::RCM: return "rcm";
+    case VertexOrdering::Degree: return "degree";
+    default: return "original";
+    }
+}
+
+// Drivers relabel their graph with VERTEX_ORDER (original, bfs, rcm or
+// degree) when it is set; returns false for an unknown name
+inline bool vertexOrderingFromEnv(VertexOrdering& ordering) {
+    ordering = VertexOrdering::Original;
+    const char* name = std::getenv("VERTEX_ORDER");
+    return !name || !*name || parseVertexOrdering(name, ordering);
+}
+
+// order[i] is the original id of the vertex placed at position i
+typedef std::vector<int> VertexOrder;
+
+// Breadth-first order over out- and in-edges, so every weakly connected
+// component comes out contiguous. Components start at their lowest id, or
+// at their lowest-degree vertex when byDegree is set, which also visits
+// each vertex's neighbors by increasing degree (Cuthill-McKee).
+inline VertexOrder breadthFirstOrder(const CSRGraph& adj, bool byDegree = false) {
+    int n = adj.size();
+    CSRGraph reverse = transposeGraph(adj);
+    auto totalDegree = [&](int v) { return adj.degree(v) + reverse.degree(v); };
+
+    std::vector<int> roots(n);
+    for (int v = 0; v < n; v++) roots[v] = v;
+    if (byDegree) {
+        std::stable_sort(roots.begin(), roots.end(),
+                         [&](int a, int b) { return totalDegree(a) < totalDegree(b); });
+    }
+
+    VertexOrder order;
+    order.reserve(n);
+    std::vector<char> seen(n, 0);
+    auto enqueue = [&](int u) {
+        if (!seen[u]) {
+            seen[u] = 1;
+            order.push_back(u);
+        }
+    };
+    for (int root : roots) {
+        size_t head = order.size();
+        enqueue(root);
+        while (head < order.size()) {
+            int v = order[head++];
+            size_t first = order.size();
+            for (int u : adj[v]) enqueue(u);
+            for (int u : reverse[v]) enqueue(u);
+            if (byDegree) {
+                std::stable_sort(order.begin() + first, order.end(),
+                                 [&](int a, int b) { return totalDegree(a) < totalDegree(b); });
+            }
+        }
+    }
+    return order;
+}
+
+inline VertexOrder computeVertexOrder(const CSRGraph& adj, VertexOrdering ordering) {
+    int n = adj.size();
+    VertexOrder order;
+    if (ordering == VertexOrdering::BFS) {
+        order = breadthFirstOrder(adj);
+    } else if (ordering == VertexOrdering::RCM) {
+        order = breadthFirstOrder(adj, true);
+        std::reverse(order.begin(), order.end());
+    } else {
+        order.resize(n);
+        for (int v = 0; v < n; v++) order[v] = v;
+        if (ordering == VertexOrdering::Degree) {
+            std::stable_sort(order.begin(), order.end(),
+                             [&](int a, int b) { return adj.degree(a) > adj.degree(b); });
+        }
+    }
+    return order;
+}
+
+// Both directions of a relabeling
+struct VertexPermutation {
+    std::vector<int> newId;     // original id -> new id
+    std::vector<int> oldId;     // new id -> original id
+
+    explicit VertexPermutation(const VertexOrder& order = VertexOrder())
+        : newId(order.size()), oldId(order) {
+        for (size_t i = 0; i < order.size(); i++) newId[order[i]] = i;
+    }
+
+    bool identity() const { return oldId.empty(); }
+
+    // Rewrite a list of new ids (e.g. a traversal result) in place
+    void toOriginal(std::vector<int>& vertices) const {
+        if (identity()) return;
+        #pragma omp parallel for
+        for (size_t i = 0; i < vertices.size(); i++) vertices[i] = oldId[vertices[i]];
+    }
+};
+
+// adj with vertex v renamed to perm.newId[v]; each row keeps its edge order
+inline CSRGraph relabelGraph(const CSRGraph& adj, const VertexPermutation& perm) {
+    return buildGraph(adj.size(), [&](int v, auto&& emit) {
+        for (int u : adj[perm.oldId[v]]) emit(perm.newId[u]);
+    });
+}
+
+#endif
@@ -0,0 +1,313 @@
+#ifndef WORK_STEALING_DFS_H
+#define WORK_STEALING_DFS_H
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <omp.h>
+#include "graph.h"
+#include "dfs_engine.h"
+#include "atomic_bitmap.h"
+#include "numa_topology.h"
+
+// Per-thread counters reported after each traversal
+struct WorkerStats {
+    long long visited = 0;        // vertices claimed and visited by this thread
+    long long roots = 0;          // new DFS trees started from the root scan
+    long long steals = 0;         // frames taken from another thread's deque
+    long long remoteSteals = 0;   // of those, from a thread on another NUMA node
+    long long failedSteals = 0;   // victim looked busy but its deque was empty
+    long long splits = 0;         // times this thread donated frames
+};
+
+struct FollowAllNeighbors {
+    bool operator()(int, int) const { return true; }
+};
+
+// Parallel DFS where each OpenMP thread runs the iterative engine on its own
+// private stack. When a thread's stack grows past splitThreshold and some
+// thread is idle, it moves the oldest half of its frames (those closest to
+// the root, which carry the most remaining work) into its shared deque.
+// Idle threads take new roots first, then steal the oldest frame from
+// another thread's deque.
+//
+// With a ThreadLayout (setLayout) each thread is pinned to its CPU, takes
+// roots from its own node's vertex block before helping other nodes, and
+// tries victims on its own node before crossing the interconnect.
+class WorkStealingDFS {
+public:
+    explicit WorkStealingDFS(int numThreads = omp_get_max_threads(), int splitThreshold = 64)
+        : numThreads_(numThreads < 1 ? 1 : numThreads),
+          splitThreshold_(splitThreshold < 2 ? 2 : splitThreshold),
+          workers_(numThreads_) {}
+
+    int numThreads() const { return numThreads_; }
+    int splitThreshold() const { return splitThreshold_; }
+    const std::vector<WorkerStats>& stats() const { return stats_; }
+
+    // Pin threads and group them by node for the following runs. Threads
+    // stay pinned after run() returns, which is what the next run wants.
+    void setLayout(const ThreadLayout& layout) { layout_ = layout; }
+
+    const ThreadLayout& layout() const { return layout_; }
+
+    // NUMA node thread tid counts as (0 without a layout)
+    int nodeOf(int tid) const { return tid < (int)layout_.node.size() ? layout_.node[tid] : 0; }
+
+    // End the current traversal early; safe to call from inside visit().
+    // Threads notice at their next frame step and return.
+    void requestStop() { stop_.store(true, std::memory_order_relaxed); }
+    bool stopRequested() const { return stop_.load(std::memory_order_relaxed); }
+
+    // Visit every vertex of adj not yet set in visited, calling
+    // visit(v, parent, tid) exactly once per vertex from the thread that
+    // claimed it (parent is -1 for a root). Roots are
+    // taken from [0, adj.size()) in increasing order, as in the serial dfs()
+    // (per node block under a layout: see nodeVertexBlocks()).
+    // The visit callback is shared by all threads and must be thread-safe.
+    template <typename Visit>
+    void run(const CSRGraph& adj, AtomicBitmap& visited, int stride, Visit visit) {
+        FollowAllNeighbors follow;
+        runRoots(adj, visited, nullptr, adj.size(), stride, visit, follow);
+    }
+
+    // Same, but only start trees from the given roots, in order.
+    // follow(u, tid) is asked before neighbor u is claimed; neighbors it
+    // rejects are skipped (used to keep ghost vertices out of the traversal).
+    template <typename Visit, typename Follow = FollowAllNeighbors>
+    void runFrom(const CSRGraph& adj, AtomicBitmap& visited, const std::vector<int>& roots,
+                 int stride, Visit visit, Follow follow = Follow()) {
+        runRoots(adj, visited, roots.data(), roots.size(), stride, visit, follow);
+    }
+
+private:
+    static const int ROOT_CHUNK = 64;
+
+    struct alignas(64) Worker {
+        std::deque<DFSFrame> local;     // touched only by the owning thread
+        std::mutex lock;
+        std::deque<DFSFrame> shared;    // oldest frame at the front
+        std::atomic<int> sharedSize{0};
+        int rootNext = 0;
+        int rootEnd = 0;
+        WorkerStats stats;
+    };
+
+    // Root list cursor for one node's block [next, end)
+    struct alignas(64) RootCursor {
+        std::atomic<int> next{0};
+        int end = 0;
+    };
+
+    // roots == nullptr means the identity list 0 .. numRoots - 1
+    template <typename Visit, typename Follow>
+    void runRoots(const CSRGraph& adj, AtomicBitmap& visited, const int* roots,
+                  int numRoots, int stride, Visit& visit, Follow& follow) {
+        roots_ = roots;
+        stop_.store(false, std::memory_order_relaxed);
+        setRootBlocks(adj, roots, numRoots);
+        idle_.store(0, std::memory_order_relaxed);
+        stats_.assign(numThreads_, WorkerStats());
+        for (Worker& w : workers_) {
+            w.local.clear();     // a stopped run can leave frames behind
+            w.shared.clear();
+            w.sharedSize.store(0, std::memory_order_relaxed);
+            w.rootNext = w.rootEnd = 0;
+        }
+
+        #pragma omp parallel num_threads(numThreads_)
+        {
+            int tid = omp_get_thread_num();
+            // The runtime may hand out fewer threads than requested
+            int team = omp_get_num_threads();
+            layout_.pin(tid);
+            #pragma omp single
+            {
+                activeThreads_ = team;
+                orderVictims();
+            }
+            if (stride > 1) {
+                workerLoop(adj, visited, StridedOrder{stride}, visit, follow, tid);
+            } else {
+                workerLoop(adj, visited, PlainOrder(), visit, follow, tid);
+            }
+        }
+    }
+
+    template <typename Order, typename Visit, typename Follow>
+    void workerLoop(const CSRGraph& adj, AtomicBitmap& visited, Order order,
+                    Visit& visit, Follow& follow, int tid) {
+        Worker& me = workers_[tid];
+        me.stats = WorkerStats();
+        std::deque<DFSFrame>& local = me.local;
+        local.clear();
+
+        while (!stop_.load(std::memory_order_relaxed)) {
+            if (local.empty() && !acquireWork(visited, visit, tid)) break;
+
+            DFSFrame& top = local.back();
+            int degree = adj.degree(top.vertex);
+            if (top.next == degree) {
+                local.pop_back();
+                continue;
+            }
+
+            int u = adj[top.vertex][order.index(top.next++, degree)];
+            if (!follow(u, tid) || !visited.tryClaim(u)) continue;
+
+            visit(u, top.vertex, tid);
+            me.stats.visited++;
+            local.push_back({u, 0});
+
+            if ((int)local.size() > splitThreshold_ &&
+                me.sharedSize.load(std::memory_order_relaxed) == 0 &&
+                idle_.load(std::memory_order_relaxed) > 0) {
+                split(me);
+            }
+        }
+        stats_[tid] = me.stats;
+    }
+
+    void split(Worker& me) {
+        size_t half = me.local.size() / 2;
+        std::lock_guard<std::mutex> guard(me.lock);
+        me.shared.insert(me.shared.end(), me.local.begin(), me.local.begin() + half);
+        me.local.erase(me.local.begin(), me.local.begin() + half);
+        me.sharedSize.store((int)me.shared.size(), std::memory_order_release);
+        me.stats.splits++;
+    }
+
+    // Refill an empty local stack; returns false once the traversal is over
+    template <typename Visit>
+    bool acquireWork(AtomicBitmap& visited, Visit& visit, int tid) {
+        Worker& me = workers_[tid];
+
+        if (me.sharedSize.load(std::memory_order_acquire) > 0) {
+            std::lock_guard<std::mutex> guard(me.lock);
+            if (!me.shared.empty()) {
+                me.local.assign(me.shared.begin(), me.shared.end());
+                me.shared.clear();
+                me.sharedSize.store(0, std::memory_order_release);
+                return true;
+            }
+        }
+
+        if (nextRootVertex(visited, me, nodeOf(tid))) {
+            visit(me.local.back().vertex, -1, tid);
+            me.stats.visited++;
+            me.stats.roots++;
+            return true;
+        }
+
+        idle_.fetch_add(1, std::memory_order_acq_rel);
+        while (true) {
+            if (idle_.load(std::memory_order_acquire) == activeThreads_) return false;
+            if (stop_.load(std::memory_order_relaxed)) return false;
+
+            for (int id : victims_[tid]) {
+                Worker& victim = workers_[id];
+                if (victim.sharedSize.load(std::memory_order_acquire) == 0) continue;
+
+                // Leave the idle count before taking work so nobody can
+                // observe every thread idle while this frame is in flight
+                idle_.fetch_sub(1, std::memory_order_acq_rel);
+                {
+                    std::lock_guard<std::mutex> guard(victim.lock);
+                    if (!victim.shared.empty()) {
+                        me.local.push_back(victim.shared.front());
+                        victim.shared.pop_front();
+                        victim.sharedSize.store((int)victim.shared.size(), std::memory_order_release);
+                        me.stats.steals++;
+                        if (nodeOf(id) != nodeOf(tid)) me.stats.remoteSteals++;
+                        return true;
+                    }
+                }
+                me.stats.failedSteals++;
+                idle_.fetch_add(1, std::memory_order_acq_rel);
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // One cursor over the whole root list, or one per node block
+    void setRootBlocks(const CSRGraph& adj, const int* roots, int numRoots) {
+        std::vector<int> blocks;
+        if (layout_.numThreads() == 0) {
+            blocks = {0, numRoots};
+        } else if (!roots) {
+            blocks = nodeVertexBlocks(adj, layout_);
+        } else {
+            blocks.assign(1, 0);
+            long long threadsBefore = 0;
+            for (int k = 0; k < layout_.numNodes; k++) {
+                threadsBefore += std::count(layout_.node.begin(), layout_.node.end(), k);
+                blocks.push_back(numRoots * threadsBefore / layout_.numThreads());
+            }
+        }
+        if (cursors_.size() + 1 != blocks.size()) cursors_ = std::vector<RootCursor>(blocks.size() - 1);
+        for (size_t k = 0; k < cursors_.size(); k++) {
+            cursors_[k].next.store(blocks[k], std::memory_order_relaxed);
+            cursors_[k].end = blocks[k + 1];
+        }
+    }
+
+    // Ring order starting after tid, threads on tid's node first
+    void orderVictims() {
+        victims_.assign(activeThreads_, std::vector<int>());
+        for (int tid = 0; tid < activeThreads_; tid++) {
+            for (int pass = 0; pass < 2; pass++) {
+                for (int k = 1; k < activeThreads_; k++) {
+                    int id = (tid + k) % activeThreads_;
+                    if ((nodeOf(id) == nodeOf(tid)) == (pass == 0)) victims_[tid].push_back(id);
+                }
+            }
+        }
+    }
+
+    // Take ROOT_CHUNK roots from node's block, or from the next node's
+    // once it runs dry
+    bool claimRootChunk(Worker& me, int node) {
+        int numCursors = cursors_.size();
+        for (int k = 0; k < numCursors; k++) {
+            RootCursor& cursor = cursors_[(node + k) % numCursors];
+            if (cursor.next.load(std::memory_order_relaxed) >= cursor.end) continue;
+            int start = cursor.next.fetch_add(ROOT_CHUNK, std::memory_order_relaxed);
+            if (start >= cursor.end) continue;
+            me.rootNext = start;
+            me.rootEnd = std::min(start + ROOT_CHUNK, cursor.end);
+            return true;
+        }
+        return false;
+    }
+
+    // Claim the next unvisited root, grabbing ROOT_CHUNK candidates at a
+    // time so threads do not contend on the cursor for every vertex.
+    bool nextRootVertex(AtomicBitmap& visited, Worker& me, int node) {
+        while (true) {
+            if (me.rootNext == me.rootEnd && !claimRootChunk(me, node)) return false;
+            int v = roots_ ? roots_[me.rootNext] : me.rootNext;
+            me.rootNext++;
+            if (visited.tryClaim(v)) {
+                me.local.push_back({v, 0});
+                return true;
+            }
+        }
+    }
+
+    int numThreads_;
+    int splitThreshold_;
+    int activeThreads_ = 1;
+    const int* roots_ = nullptr;
+    std::vector<Worker> workers_;
+    std::vector<WorkerStats> stats_;
+    ThreadLayout layout_;
+    std::vector<RootCursor> cursors_ = std::vector<RootCursor>(1);
+    std::vector<std::vector<int>> victims_;
+    std::atomic<int> idle_{0};
+    std::atomic<bool> stop_{false};
+};
+
+#endif